@@ -144,83 +144,121 @@ static int _print_enter_array(nanocbor_value_t *value, unsigned indent)
     return -1;
 }
 
-static int _print_float(nanocbor_value_t *value)
+static int _print_bstr(nanocbor_value_t *value, bool indefinite)
 {
-    bool test = false;
-    uint8_t simple = 0;
-    float fvalue = 0;
-    double dvalue = 0;
-    if (nanocbor_get_bool(value, &test) >= NANOCBOR_OK) {
-        test ? printf("true") : printf("false");
+    nanocbor_value_t chunks;
+    const char *sep = "";
+    int res = nanocbor_enter_bstr_chunks(value, &chunks);
+    if (res < 0) {
+        return res;
     }
-    else if (nanocbor_get_null(value) >= NANOCBOR_OK) {
-        printf("null");
+    if (indefinite) {
+        printf("(_ ");
     }
-    else if (nanocbor_get_undefined(value) >= NANOCBOR_OK) {
-        printf("\"undefined\"");
+    while (!nanocbor_at_end(&chunks)) {
+        const uint8_t *buf = NULL;
+        size_t len = 0;
+        res = nanocbor_get_next_chunk(&chunks, &buf, &len);
+        if (res < 0) {
+            return res;
+        }
+        printf("%sh\'", sep);
+        for (size_t iter = 0; iter < len; iter++) {
+            printf("%.2x", buf[iter]);
+        }
+        printf("\'");
+        sep = ", ";
     }
-    else if (nanocbor_get_simple(value, &simple) >= NANOCBOR_OK) {
-        printf("\"simple(%u)\"", simple);
+    if (indefinite) {
+        printf(")");
     }
-    else if (nanocbor_get_float(value, &fvalue) >= 0) {
-        printf("%f", fvalue);
+    nanocbor_leave_container(value, &chunks);
+    return 0;
+}
+
+/* Text string chunks are printed as a single string */
+static int _print_tstr(nanocbor_value_t *value)
+{
+    nanocbor_value_t chunks;
+    int res = nanocbor_enter_tstr_chunks(value, &chunks);
+    if (res < 0) {
+        return res;
+    }
+    printf("\"");
+    while (!nanocbor_at_end(&chunks)) {
+        const uint8_t *buf = NULL;
+        size_t len = 0;
+        res = nanocbor_get_next_chunk(&chunks, &buf, &len);
+        if (res < 0) {
+            return res;
+        }
+        printf("%.*s", (int)len, buf);
     }
-    else if (nanocbor_get_double(value, &dvalue) >= 0) {
+    printf("\"");
+    nanocbor_leave_container(value, &chunks);
+    return 0;
+}
+
+static int _print_float(nanocbor_value_t *value,
+                        const nanocbor_header_t *header)
+{
+    if (header->len >= 1 + sizeof(uint16_t)) {
+        double dvalue = 0;
+        if (nanocbor_get_double(value, &dvalue) < 0) {
+            return -1;
+        }
         printf("%f", dvalue);
+        return 0;
     }
-    else {
-        return -1;
+    switch (header->value) {
+    case NANOCBOR_SIMPLE_FALSE:
+        printf("false");
+        break;
+    case NANOCBOR_SIMPLE_TRUE:
+        printf("true");
+        break;
+    case NANOCBOR_SIMPLE_NULL:
+        printf("null");
+        break;
+    case NANOCBOR_SIMPLE_UNDEF:
+        printf("\"undefined\"");
+        break;
+    default:
+        printf("\"simple(%u)\"", (unsigned)header->value);
     }
-    return 0;
+    return nanocbor_advance_header(value, header);
 }
 
 /* NOLINTNEXTLINE(misc-no-recursion, readability-function-cognitive-complexity) */
 static int _parse_type(nanocbor_value_t *value, unsigned indent)
 {
-    uint8_t type = nanocbor_get_type(value);
+    nanocbor_header_t header;
     if (indent > MAX_DEPTH) {
         return -2;
     }
-    int res = 0;
-    switch (type) {
+    int res = nanocbor_peek_header(value, &header);
+    if (res < 0) {
+        return -1;
+    }
+    switch (header.type) {
     case NANOCBOR_TYPE_UINT: {
-        uint64_t uint = 0;
-        res = nanocbor_get_uint64(value, &uint);
-        if (res >= 0) {
-            printf("%" PRIu64, uint);
-        }
+        printf("%" PRIu64, header.value);
+        res = nanocbor_advance_header(value, &header);
     } break;
     case NANOCBOR_TYPE_NINT: {
-        int64_t nint = 0;
-        res = nanocbor_get_int64(value, &nint);
-        if (res >= 0) {
-            printf("%" PRIi64, nint);
+        if (header.value == UINT64_MAX) {
+            printf("-18446744073709551616");
         }
+        else {
+            printf("-%" PRIu64, header.value + 1);
+        }
+        res = nanocbor_advance_header(value, &header);
     } break;
     case NANOCBOR_TYPE_BSTR: {
-        const uint8_t *buf = NULL;
-        size_t len = 0;
-        res = nanocbor_get_bstr(value, &buf, &len);
-        if (res >= 0) {
-            if (!buf) {
-                return -1;
-            }
-            size_t iter = 0;
-            printf("h\'");
-            while (iter < len) {
-                printf("%.2x", buf[iter]);
-                iter++;
-            }
-            printf("\'");
-        }
+        res = _print_bstr(value, header.indefinite);
     } break;
     case NANOCBOR_TYPE_TSTR: {
-        const uint8_t *buf = NULL;
-        size_t len = 0;
-        res = nanocbor_get_tstr(value, &buf, &len);
-        if (res >= 0) {
-            printf("\"%.*s\"", (int)len, buf);
-        }
+        res = _print_tstr(value);
     } break;
     case NANOCBOR_TYPE_ARR: {
         res = _print_enter_array(value, indent);
@@ -229,16 +267,13 @@ static int _parse_type(nanocbor_value_t *value, unsigned indent)
         res = _print_enter_map(value, indent);
     } break;
     case NANOCBOR_TYPE_FLOAT: {
-        res = _print_float(value);
+        res = _print_float(value, &header);
     } break;
     case NANOCBOR_TYPE_TAG: {
-        uint32_t tag = 0;
-        int res = nanocbor_get_tag(value, &tag);
-        if (res >= NANOCBOR_OK) {
-            printf("%" PRIu32 "(", tag);
-            _parse_type(value, 0);
-            printf(")");
-        }
+        nanocbor_advance_header(value, &header);
+        printf("%" PRIu64 "(", header.value);
+        _parse_type(value, 0);
+        printf(")");
         break;
     }
     default:
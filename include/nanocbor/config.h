@@ -23,12 +23,40 @@ extern "C" {
 #endif
 
 /**
- * @brief Recursion limit when using @ref nanocbor_skip.
+ * @brief Nesting limit when using @ref nanocbor_skip.
  */
 #ifndef NANOCBOR_RECURSION_MAX
 #define NANOCBOR_RECURSION_MAX 10
 #endif
 
+/**
+ * @brief Use SIMD instructions for bulk array decoding when the target
+ * supports them
+ *
+ * Set to 0 to always use the scalar implementation.
+ */
+#ifndef NANOCBOR_USE_SIMD
+#define NANOCBOR_USE_SIMD 1
+#endif
+
+/**
+ * @brief Write memory buffers of encoders set up with
+ * @ref nanocbor_encoder_init directly instead of through the fits and append
+ * function pointers
+ *
+ * Set to 0 to always use the function pointers.
+ */
+#ifndef NANOCBOR_ENCODER_INLINE_MEMORY
+#define NANOCBOR_ENCODER_INLINE_MEMORY 1
+#endif
+
+/**
+ * @brief Initial capacity of a growable encoder buffer
+ */
+#ifndef NANOCBOR_GROWBUF_MIN
+#define NANOCBOR_GROWBUF_MIN 64
+#endif
+
 /**
  * @brief library providing htonll, be64toh or equivalent. Must also provide
  * the reverse operation (ntohll, htobe64 or equivalent)
@@ -103,6 +103,33 @@ extern "C" {
 #define NANOCBOR_TAG_BIGFLOATS (0x5) /**< Bigfloat */
 /** @} */
 
+/**
+ * @name RFC 8746 typed array tags
+ *
+ * Typed array tags are composed of @ref NANOCBOR_TAG_TYPED_ARRAY, the
+ * element kind flags and the element size exponent. The named tags below are
+ * the big endian variants.
+ * @{
+ */
+#define NANOCBOR_TAG_TYPED_ARRAY (64U) /**< First typed array tag */
+#define NANOCBOR_TAG_TYPED_ARRAY_LAST (87U) /**< Last typed array tag */
+#define NANOCBOR_TYPED_ARRAY_FLOAT (0x10U) /**< Floating point elements */
+#define NANOCBOR_TYPED_ARRAY_SIGNED (0x08U) /**< Signed integer elements */
+#define NANOCBOR_TYPED_ARRAY_LE (0x04U) /**< Little endian elements */
+#define NANOCBOR_TYPED_ARRAY_SIZE_MASK (0x03U) /**< Element size exponent */
+#define NANOCBOR_TAG_TYPED_UINT8 (64U) /**< uint8_t elements  */
+#define NANOCBOR_TAG_TYPED_UINT16 (65U) /**< uint16_t elements */
+#define NANOCBOR_TAG_TYPED_UINT32 (66U) /**< uint32_t elements */
+#define NANOCBOR_TAG_TYPED_UINT64 (67U) /**< uint64_t elements */
+#define NANOCBOR_TAG_TYPED_SINT8 (72U) /**< int8_t elements   */
+#define NANOCBOR_TAG_TYPED_SINT16 (73U) /**< int16_t elements  */
+#define NANOCBOR_TAG_TYPED_SINT32 (74U) /**< int32_t elements  */
+#define NANOCBOR_TAG_TYPED_SINT64 (75U) /**< int64_t elements  */
+#define NANOCBOR_TAG_TYPED_FLOAT16 (80U) /**< half precision elements   */
+#define NANOCBOR_TAG_TYPED_FLOAT32 (81U) /**< single precision elements */
+#define NANOCBOR_TAG_TYPED_FLOAT64 (82U) /**< double precision elements */
+/** @} */
+
 /**
  * @brief NanoCBOR decoder errors
  */
@@ -137,6 +164,27 @@ typedef enum {
      * @brief Decoder could not find the requested entry
      */
     NANOCBOR_NOT_FOUND = -5,
+
+    /**
+     * @brief Decoder requires more input to decode the item, only returned
+     *        by streaming decoders
+     */
+    NANOCBOR_ERR_NEED_MORE = -6,
+
+    /**
+     * @brief Text string is not valid UTF-8
+     */
+    NANOCBOR_ERR_INVALID_UTF8 = -7,
+
+    /**
+     * @brief Item is well-formed but not deterministically encoded
+     */
+    NANOCBOR_ERR_NOT_DETERMINISTIC = -8,
+
+    /**
+     * @brief Map contains the same key more than once
+     */
+    NANOCBOR_ERR_DUPLICATE_KEY = -9,
 } nanocbor_error_t;
 
 /**
@@ -149,6 +197,47 @@ typedef struct nanocbor_value {
     uint8_t flags; /**< Flags for decoding hints                   */
 } nanocbor_value_t;
 
+/**
+ * @brief Decoded item header
+ */
+typedef struct nanocbor_header {
+    uint64_t value; /**< Argument: value, length, item count, tag number,
+                     *   simple value or floating point bits */
+    uint8_t type; /**< Major type                                  */
+    uint8_t len; /**< Length of the header in bytes              */
+    bool indefinite; /**< Indefinite length string or container      */
+} nanocbor_header_t;
+
+/**
+ * @brief RFC 8746 typed array view into the decoded buffer
+ */
+typedef struct nanocbor_typed_array {
+    const uint8_t *data; /**< Element data inside the decoded buffer      */
+    size_t len; /**< Length of the element data in bytes         */
+    size_t num; /**< Number of elements                          */
+    uint8_t tag; /**< Typed array tag describing the element type */
+    uint8_t elem_size; /**< Size of a single element in bytes           */
+} nanocbor_typed_array_t;
+
+/**
+ * @brief Container state used by the non-recursive traversal functions
+ */
+typedef struct nanocbor_stack_entry {
+    uint64_t remaining; /**< Number of items remaining in the container */
+    uint8_t flags; /**< Decoder flags of the container             */
+} nanocbor_stack_entry_t;
+
+/**
+ * @brief Container state used by @ref nanocbor_check_deterministic_stack
+ */
+typedef struct nanocbor_det_entry {
+    uint64_t remaining; /**< Number of items remaining in the container */
+    const uint8_t *key; /**< Start of the current map key               */
+    const uint8_t *prev; /**< Previous map key, NULL if none             */
+    size_t prev_len; /**< Length of the previous map key             */
+    bool map; /**< Container is a map                         */
+} nanocbor_det_entry_t;
+
 /**
  * @brief Encoder context forward declaration
  */
@@ -191,8 +280,89 @@ typedef bool (*nanocbor_encoder_fits)(nanocbor_encoder_t *enc, void *ctx, size_t
  */
 typedef void (*nanocbor_encoder_append)(nanocbor_encoder_t *enc, void *ctx, const uint8_t *data, size_t len);
 
+/**
+ * @brief Allocator for @ref nanocbor_encoder_growable_init
+ *
+ * Same semantics as realloc(3): @p ptr is NULL on the first allocation, the
+ * contents are preserved up to the smaller of the old and new size.
+ *
+ * @param   ctx     The context ptr supplied in the
+ *                  @ref nanocbor_encoder_growable_init call
+ * @param   ptr     Buffer to resize, may be NULL
+ * @param   len     Requested size in bytes
+ *
+ * @return          The resized buffer, NULL on failure
+ */
+typedef void *(*nanocbor_realloc_t)(void *ctx, void *ptr, size_t len);
+
 /** @} */
 
+/**
+ * @brief Growable buffer for @ref nanocbor_encoder_growable_init
+ *
+ * After encoding, the CBOR data is available in @p buf, the buffer is owned
+ * by the caller and must be released with the allocator that created it.
+ */
+typedef struct nanocbor_growbuf {
+    uint8_t *buf; /**< Encoded data, NULL until the first append       */
+    size_t len; /**< Number of bytes encoded                           */
+    size_t capacity; /**< Allocated size of @p buf                      */
+    nanocbor_realloc_t realloc_func; /**< Allocator, NULL for realloc(3) */
+    void *ctx; /**< Context ptr passed to the allocator               */
+} nanocbor_growbuf_t;
+
+/**
+ * @brief Staging buffer for @ref nanocbor_encoder_buffered_init
+ */
+typedef struct nanocbor_stream_buf {
+    uint8_t *buf; /**< Staging buffer                                  */
+    size_t size; /**< Size of the staging buffer                       */
+    size_t used; /**< Number of staged bytes                           */
+    nanocbor_encoder_append append; /**< User append function          */
+    nanocbor_encoder_fits fits; /**< User fits function                */
+    void *ctx; /**< Context ptr passed to the user functions           */
+} nanocbor_stream_buf_t;
+
+/**
+ * @brief I/O vector, same layout as `struct iovec` from `<sys/uio.h>`
+ */
+typedef struct nanocbor_iovec {
+    const void *base; /**< Start of the data                  */
+    size_t len; /**< Length of the data in bytes               */
+} nanocbor_iovec_t;
+
+/**
+ * @brief Smallest payload size referenced by a vectored encoder
+ *
+ * Larger than any header, which are always copied.
+ */
+#define NANOCBOR_IOVEC_THRESHOLD_MIN (1U + sizeof(uint64_t) + 1U)
+
+/**
+ * @brief Decoder context for CBOR split over a list of segments
+ */
+typedef struct nanocbor_seg_value {
+    const nanocbor_iovec_t *segs; /**< Segments holding the CBOR data   */
+    size_t num; /**< Number of segments                                */
+    size_t seg; /**< Index of the current segment                      */
+    size_t off; /**< Offset in the current segment                     */
+    uint64_t remaining; /**< Number of items remaining in the container */
+    uint8_t flags; /**< Decoder flags                                  */
+} nanocbor_seg_value_t;
+
+/**
+ * @brief Vectored output for @ref nanocbor_encoder_iovec_init
+ */
+typedef struct nanocbor_iovec_buf {
+    nanocbor_iovec_t *iov; /**< Output vectors                           */
+    size_t max; /**< Number of vectors available in @p iov           */
+    size_t num; /**< Number of vectors used                          */
+    uint8_t *buf; /**< Storage for headers and small payloads        */
+    size_t size; /**< Size of @p buf                                 */
+    size_t used; /**< Number of bytes used in @p buf                 */
+    size_t threshold; /**< Payloads of this size and up are referenced */
+} nanocbor_iovec_buf_t;
+
 /**
  * @brief encoder context
  */
@@ -207,8 +377,200 @@ struct nanocbor_encoder {
         void *context; /**< Context ptr supplied to the custom functions */
     };
     uint8_t *end; /**< end of the buffer                      */
+    struct nanocbor_container *container; /**< Innermost open container */
+    uint8_t flags; /**< Encoder flags                          */
 };
 
+/**
+ * @brief Encoder only produces RFC 8949 deterministically encoded items
+ *
+ * Indefinite length items are rejected, maps must be encoded with
+ * @ref nanocbor_fmt_sorted_map_open to have their keys sorted.
+ */
+#define NANOCBOR_ENCODER_FLAG_CANONICAL (0x01U)
+
+/**
+ * @brief Encoder writes into a memory buffer
+ */
+#define NANOCBOR_ENCODER_FLAG_MEMORY (0x02U)
+
+/**
+ * @brief Encoder only counts the encoded length
+ */
+#define NANOCBOR_ENCODER_FLAG_SIZE (0x04U)
+
+/**
+ * @brief Definite length container with a header patched on close
+ */
+typedef struct nanocbor_container {
+    uint8_t *start; /**< Reserved header space, NULL if it did not fit */
+    size_t len; /**< Encoded length at the start of the body        */
+    uint64_t items; /**< Number of items started in the body           */
+    uint64_t pending; /**< Items still owed to nested definite items     */
+    size_t indefinite; /**< Depth of open nested indefinite length items  */
+    struct nanocbor_container *parent; /**< Enclosing open container   */
+    uint8_t type; /**< Major type mask of the container              */
+    bool indexed; /**< Item offsets are stored below the buffer end   */
+} nanocbor_container_t;
+
+/**
+ * @brief Map staged in an arena to emit its entries sorted by key
+ */
+typedef struct nanocbor_sorted_map {
+    nanocbor_encoder_t enc; /**< Encoder for the keys and values of the map */
+    nanocbor_encoder_t *parent; /**< Encoder the map is emitted to   */
+    uint8_t *arena; /**< Staging arena                                */
+    size_t size; /**< Size of the staging arena                    */
+    nanocbor_container_t container; /**< Item offsets of the entries   */
+} nanocbor_sorted_map_t;
+
+/**
+ * @brief Structural index entry, describes a single CBOR item
+ */
+typedef struct nanocbor_index_entry {
+    size_t offset; /**< Offset of the item header in the buffer       */
+    size_t end; /**< Offset just past the item and its children    */
+    size_t next; /**< Index of the entry following the item         */
+    uint64_t argument; /**< Header argument: value, length or item count  */
+    uint8_t type; /**< Major type of the item                        */
+    uint8_t flags; /**< Flags for the item                            */
+} nanocbor_index_entry_t;
+
+/**
+ * @brief Structural index over a CBOR buffer
+ */
+typedef struct nanocbor_index {
+    const uint8_t *buf; /**< Indexed buffer                              */
+    size_t len; /**< Length of the indexed buffer                */
+    nanocbor_index_entry_t *entries; /**< Entry storage                   */
+    size_t capacity; /**< Number of entries available in the storage  */
+    size_t num; /**< Number of entries used                      */
+    size_t hint; /**< Entry index expected on the next lookup     */
+} nanocbor_index_t;
+
+/**
+ * @brief index entry is an indefinite length item
+ */
+#define NANOCBOR_INDEX_FLAG_INDEFINITE (0x01U)
+
+/**
+ * @brief Callbacks fired by @ref nanocbor_parse_events
+ *
+ * Every callback is optional, events without a callback are ignored. A
+ * callback returning a negative value aborts parsing, the value is returned
+ * by @ref nanocbor_parse_events. Strings point into the parsed buffer.
+ */
+typedef struct nanocbor_callbacks {
+    /** Unsigned integer */
+    int (*on_uint)(void *ctx, uint64_t value);
+    /** Negative integer, the value is -1 - @p value */
+    int (*on_nint)(void *ctx, uint64_t value);
+    /** Byte string or a chunk of an indefinite length byte string */
+    int (*on_bstr)(void *ctx, const uint8_t *buf, size_t len);
+    /** Text string or a chunk of an indefinite length text string */
+    int (*on_tstr)(void *ctx, const uint8_t *buf, size_t len);
+    /** Start of an array, @p len is 0 for indefinite length arrays */
+    int (*on_start_array)(void *ctx, uint64_t len, bool indefinite);
+    /** End of an array */
+    int (*on_end_array)(void *ctx);
+    /** Start of a map, @p len is the number of pairs, 0 if indefinite */
+    int (*on_start_map)(void *ctx, uint64_t len, bool indefinite);
+    /** End of a map */
+    int (*on_end_map)(void *ctx);
+    /** Start of an indefinite length string of major type @p type */
+    int (*on_start_chunks)(void *ctx, uint8_t type);
+    /** End of an indefinite length string */
+    int (*on_end_chunks)(void *ctx);
+    /** Tag, followed by the events of the tagged item */
+    int (*on_tag)(void *ctx, uint64_t tag);
+    /** Half, single or double precision floating point value */
+    int (*on_float)(void *ctx, double value);
+    /** Simple value, including false, true, null and undefined */
+    int (*on_simple)(void *ctx, uint8_t value);
+} nanocbor_callbacks_t;
+
+/**
+ * @brief Types of struct members decoded by @ref nanocbor_get_struct
+ */
+typedef enum {
+    NANOCBOR_FIELD_UINT8, /**< uint8_t                                    */
+    NANOCBOR_FIELD_UINT16, /**< uint16_t                                   */
+    NANOCBOR_FIELD_UINT32, /**< uint32_t                                   */
+    NANOCBOR_FIELD_UINT64, /**< uint64_t                                   */
+    NANOCBOR_FIELD_INT8, /**< int8_t                                     */
+    NANOCBOR_FIELD_INT16, /**< int16_t                                    */
+    NANOCBOR_FIELD_INT32, /**< int32_t                                    */
+    NANOCBOR_FIELD_INT64, /**< int64_t                                    */
+    NANOCBOR_FIELD_BOOL, /**< bool                                       */
+    NANOCBOR_FIELD_FLOAT, /**< float                                      */
+    NANOCBOR_FIELD_DOUBLE, /**< double                                     */
+    NANOCBOR_FIELD_BSTR, /**< nanocbor_str_t pointing into the buffer    */
+    NANOCBOR_FIELD_TSTR, /**< nanocbor_str_t pointing into the buffer    */
+    NANOCBOR_FIELD_VALUE, /**< nanocbor_value_t positioned at the value  */
+} nanocbor_field_type_t;
+
+/**
+ * @brief String member decoded by @ref nanocbor_get_struct
+ */
+typedef struct nanocbor_str {
+    const uint8_t *buf; /**< String inside the decoded buffer           */
+    size_t len; /**< Length of the string in bytes              */
+} nanocbor_str_t;
+
+/**
+ * @brief Struct member description for @ref nanocbor_get_struct
+ */
+typedef struct nanocbor_field {
+    const char *name; /**< Text string key, NULL for an integer key    */
+    int64_t key; /**< Integer key, used when name is NULL         */
+    size_t offset; /**< Offset of the member in the struct          */
+    uint8_t type; /**< Member type, a nanocbor_field_type_t        */
+    uint8_t flags; /**< Field flags                                 */
+} nanocbor_field_t;
+
+/**
+ * @brief field must be present in the map
+ */
+#define NANOCBOR_FIELD_FLAG_REQUIRED (0x01U)
+
+/**
+ * @brief Maximum number of fields in a struct description
+ */
+#define NANOCBOR_STRUCT_FIELDS_MAX (64U)
+
+/**
+ * @brief Empty slot in the perfect hash table of a struct description
+ */
+#define NANOCBOR_STRUCT_SLOT_EMPTY (UINT8_MAX)
+
+/**
+ * @brief Struct description for @ref nanocbor_get_struct
+ *
+ * The perfect hash table maps the hash of every key to the index of its
+ * field. It is generated by `tools/nanocbor_struct_gen.py`, without a table
+ * the fields are searched linearly.
+ */
+typedef struct nanocbor_struct {
+    const nanocbor_field_t *fields; /**< Field descriptions              */
+    size_t num_fields; /**< Number of fields                            */
+    const uint8_t *slots; /**< Perfect hash table, may be NULL             */
+    uint32_t slot_mask; /**< Number of slots minus one, power of two     */
+    uint32_t seed; /**< Seed of the perfect hash function           */
+} nanocbor_struct_t;
+
+/**
+ * @brief Key slot for @ref nanocbor_check_map_keys
+ */
+typedef struct nanocbor_key_slot {
+    const uint8_t *key; /**< Encoded key, NULL for an empty slot */
+    size_t len; /**< Length of the encoded key           */
+} nanocbor_key_slot_t;
+
+/**
+ * @brief validation also checks that text strings are valid UTF-8
+ */
+#define NANOCBOR_VALIDATE_FLAG_UTF8 (0x01U)
+
 /**
  * @name decoder flags
  * @{
@@ -223,6 +585,26 @@ struct nanocbor_encoder {
  * @brief decoder value is inside an indefinite length container
  */
 #define NANOCBOR_DECODER_FLAG_INDEFINITE (0x02U)
+
+/**
+ * @brief decoder value decodes a stream, more input might follow
+ */
+#define NANOCBOR_DECODER_FLAG_STREAM (0x04U)
+
+/**
+ * @brief decoder value iterates over the chunks of a text string
+ */
+#define NANOCBOR_DECODER_FLAG_TSTR_CHUNKS (0x08U)
+
+/**
+ * @brief decoder value decodes maps with deterministically sorted keys
+ */
+#define NANOCBOR_DECODER_FLAG_SORTED (0x10U)
+
+/**
+ * @brief decoder value only returns text strings that are valid UTF-8
+ */
+#define NANOCBOR_DECODER_FLAG_STRICT_UTF8 (0x20U)
 /** @} */
 
 /**
@@ -243,6 +625,99 @@ struct nanocbor_encoder {
 void nanocbor_decoder_init(nanocbor_value_t *value, const uint8_t *buf,
                            size_t len);
 
+/**
+ * @brief Mark the input of a decoder as deterministically encoded
+ *
+ * The keys of all maps decoded are expected to be sorted bytewise by their
+ * encoding as required by RFC 8949 section 4.2.1. Key lookups stop as soon
+ * as the position of the key is passed. Containers entered from the decoder
+ * inherit the mode.
+ *
+ * @param[in]   value   decoder value context
+ */
+void nanocbor_decoder_set_sorted(nanocbor_value_t *value);
+
+/**
+ * @brief Enable strict UTF-8 checking on a decoder
+ *
+ * Text strings and chunks of indefinite length text strings that are not
+ * valid UTF-8 are rejected with @ref NANOCBOR_ERR_INVALID_UTF8. Containers
+ * entered from the decoder inherit the mode.
+ *
+ * @param[in]   value   decoder value context
+ */
+void nanocbor_decoder_set_strict_utf8(nanocbor_value_t *value);
+
+/**
+ * @brief Check whether @p buf is valid UTF-8
+ *
+ * Uses vectorized kernels selected at runtime on x86-64 when
+ * @ref NANOCBOR_USE_SIMD is enabled.
+ *
+ * @param[in]   buf     Buffer to check
+ * @param[in]   len     Length of @p buf in bytes
+ *
+ * @return              NANOCBOR_OK if @p buf is valid UTF-8
+ * @return              NANOCBOR_ERR_INVALID_UTF8 otherwise
+ */
+int nanocbor_check_utf8(const uint8_t *buf, size_t len);
+
+/**
+ * @brief Initialize a decoder context for input that arrives in parts
+ *
+ * The decoder starts with the first @p len bytes of @p buf, further input is
+ * appended to @p buf by the caller and announced with
+ * @ref nanocbor_decoder_stream_feed. When an item is not completely available
+ * yet, functions return @ref NANOCBOR_ERR_NEED_MORE without advancing, the
+ * call can be repeated after more input is fed. Strings are only returned
+ * once they are completely available, they are never split.
+ *
+ * Containers entered from a streaming decoder are streaming as well. Input
+ * must be fed to the innermost container that is being decoded, leaving the
+ * container passes the input on to the parent.
+ *
+ * @param[in]   value   decoder value context
+ * @param[in]   buf     Buffer to decode from
+ * @param[in]   len     Number of bytes currently available in @p buf
+ */
+void nanocbor_decoder_stream_init(nanocbor_value_t *value, const uint8_t *buf,
+                                  size_t len);
+
+/**
+ * @brief Announce @p len additional bytes of input to a streaming decoder
+ *
+ * The bytes must be appended directly after the input already available to
+ * the decoder. Only @p value sees the new input: containers entered from
+ * @p value receive it when they are left, values copied from @p value, such
+ * as the result of @ref nanocbor_get_key_tstr, are updated with
+ * @ref nanocbor_decoder_stream_sync.
+ *
+ * @param[in]   value   streaming decoder value context
+ * @param[in]   len     Number of bytes appended
+ */
+void nanocbor_decoder_stream_feed(nanocbor_value_t *value, size_t len);
+
+/**
+ * @brief Update a value derived from @p parent with the input fed to it
+ *
+ * Copies the end of the available input and the end of stream state of
+ * @p parent to @p value, which must decode the same buffer.
+ *
+ * @param[in]   value   streaming decoder value context to update
+ * @param[in]   parent  streaming decoder value context that was fed
+ */
+void nanocbor_decoder_stream_sync(nanocbor_value_t *value,
+                                  const nanocbor_value_t *parent);
+
+/**
+ * @brief Mark the end of the input of a streaming decoder
+ *
+ * Afterwards running out of input is reported as @ref NANOCBOR_ERR_END.
+ *
+ * @param[in]   value   streaming decoder value context
+ */
+void nanocbor_decoder_stream_finish(nanocbor_value_t *value);
+
 /**
  * @brief Retrieve the type of the CBOR value at the current position
  *
@@ -263,6 +738,51 @@ int nanocbor_get_type(const nanocbor_value_t *value);
  */
 bool nanocbor_at_end(const nanocbor_value_t *it);
 
+/**
+ * @brief Decode the header of the CBOR item at the current position
+ *
+ * Retrieves the major type, the argument and the length of the header in a
+ * single pass without advancing @p value. For floating point values the
+ * argument holds the raw bits of the value, the header length indicates the
+ * precision. For simple values the argument is the simple value number.
+ *
+ * @param[in]   value   decoder value context
+ * @param[out]  header  decoded header
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END if the buffer or container is
+ *                      exhausted
+ * @return              NANOCBOR_ERR_INVALID_TYPE on a reserved or otherwise
+ *                      malformed header
+ */
+int nanocbor_peek_header(const nanocbor_value_t *value,
+                         nanocbor_header_t *header);
+
+/**
+ * @brief Consume the item header previously decoded with
+ *        @ref nanocbor_peek_header
+ *
+ * Integers, simple values and floating point values are consumed completely.
+ * For definite length byte and text strings the string content, starting at
+ * `value->cur + header->len`, is consumed as well. For tags only the tag
+ * header is consumed, the tagged item remains as next item. Containers and
+ * indefinite length strings are not consumed by this function, use the
+ * functions to enter them instead.
+ *
+ * @pre @p header was decoded from the current position of @p value
+ *
+ * @param[in]   value   decoder value context
+ * @param[in]   header  header of the current item
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE on containers and indefinite
+ *                      length strings
+ * @return              NANOCBOR_ERR_END if the string content exceeds the
+ *                      buffer
+ */
+int nanocbor_advance_header(nanocbor_value_t *value,
+                            const nanocbor_header_t *header);
+
 /**
  * @brief Retrieve a positive integer as uint8_t from the stream
  *
@@ -398,7 +918,11 @@ int nanocbor_get_int64(nanocbor_value_t *cvalue, int64_t *value);
  * @param[out]  e       returned exponent
  *
  * @return              NANOCBOR_OK on success
- * @return              negative on error
+ * @return              NANOCBOR_NOT_FOUND if the tag is not a decimal
+ *                      fraction
+ * @return              NANOCBOR_ERR_NEED_MORE if a stream ends within the
+ *                      decimal fraction, @p cvalue is not advanced
+ * @return              negative on other errors
  */
 int nanocbor_get_decimal_frac(nanocbor_value_t *cvalue, int32_t *e, int32_t *m);
 
@@ -435,100 +959,357 @@ int nanocbor_get_tstr(nanocbor_value_t *cvalue, const uint8_t **buf,
                       size_t *len);
 
 /**
- * @brief Search for a tstr key in a map.
- *
- * The resulting @p value is undefined if @p key was not found.
+ * @brief Enter a byte string to iterate over its chunks
  *
- * @pre @p start is inside a map
- *
- * @param[in]   start   pointer to the map to search
- * @param[in]   key     pointer to the text string key
- * @param[out]  value   pointer to the tstr value containing @p key if found
- *
- * @return              NANOCBOR_OK if @p key was found
- * @return              negative on error / not found
- */
-int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
-                          nanocbor_value_t *value);
-
-/**
- * @brief Enter a array type
+ * Indefinite length byte strings consist of a number of definite length
+ * chunks, a definite length byte string is handled as a single chunk. The
+ * chunks are retrieved with @ref nanocbor_get_next_chunk until
+ * @ref nanocbor_at_end returns true, afterwards
+ * @ref nanocbor_leave_container must be called on the parent.
  *
  * @param[in]   it      CBOR value to decode from
- * @param[out]  array   CBOR value to decode the array members with
+ * @param[out]  chunks  Chunk iterator for the byte string
  *
  * @return              NANOCBOR_OK on success
  * @return              negative on error
  */
-int nanocbor_enter_array(const nanocbor_value_t *it, nanocbor_value_t *array);
+int nanocbor_enter_bstr_chunks(const nanocbor_value_t *it,
+                               nanocbor_value_t *chunks);
 
 /**
- * @brief Enter a map type
+ * @brief Enter a text string to iterate over its chunks
+ *
+ * See @ref nanocbor_enter_bstr_chunks
  *
  * @param[in]   it      CBOR value to decode from
- * @param[out]  map     CBOR value to decode the map members with
+ * @param[out]  chunks  Chunk iterator for the text string
  *
  * @return              NANOCBOR_OK on success
  * @return              negative on error
  */
-int nanocbor_enter_map(const nanocbor_value_t *it, nanocbor_value_t *map);
+int nanocbor_enter_tstr_chunks(const nanocbor_value_t *it,
+                               nanocbor_value_t *chunks);
 
 /**
- * @brief leave the container
+ * @brief Retrieve the next chunk of a string entered with
+ *        @ref nanocbor_enter_bstr_chunks or @ref nanocbor_enter_tstr_chunks
  *
- * This must be called with the same @ref nanocbor_value_t struct that was used
- * to enter the container. Furthermore, the @p container must be at the end of
- * the container.
+ * The chunk is not copied, @p buf points into the decoded buffer.
  *
- * @param[in]   it          parent CBOR structure
- * @param[in]   container   exhausted CBOR container
+ * @param[in]   chunks  Chunk iterator
+ * @param[out]  buf     pointer to the chunk
+ * @param[out]  len     length of the chunk
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END when all chunks are consumed
+ * @return              negative on error
  */
-void nanocbor_leave_container(nanocbor_value_t *it,
-                              nanocbor_value_t *container);
+int nanocbor_get_next_chunk(nanocbor_value_t *chunks, const uint8_t **buf,
+                            size_t *len);
 
 /**
- * @brief Retrieve a tag as positive uint32_t from the stream
+ * @brief Copy a definite or indefinite length byte string into @p buf
  *
- * The resulting @p value is undefined if the result is an error condition
+ * The chunks of an indefinite length byte string are concatenated. The value
+ * is only advanced on success.
  *
- * @param[in]   cvalue  CBOR value to decode from
- * @param[out]  tag     returned tag as positive integer
+ * @param[in]       cvalue  CBOR value to decode from
+ * @param[out]      buf     buffer to copy the byte string into
+ * @param[in,out]   len     size of @p buf, length of the byte string on
+ *                          success
  *
  * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW if @p buf is too small
+ * @return              negative on error
  */
-int nanocbor_get_tag(nanocbor_value_t *cvalue, uint32_t *tag);
+int nanocbor_get_bstr_concat(nanocbor_value_t *cvalue, uint8_t *buf,
+                             size_t *len);
 
 /**
- * @brief Retrieve a null value from the stream
+ * @brief Copy a definite or indefinite length text string into @p buf
  *
- * This function checks if the next CBOR value is a NULL value and advances to
- * the next value if no error is detected
+ * See @ref nanocbor_get_bstr_concat. No terminating null byte is added.
  *
- * @param[in]   cvalue  CBOR value to decode from
+ * @param[in]       cvalue  CBOR value to decode from
+ * @param[out]      buf     buffer to copy the text string into
+ * @param[in,out]   len     size of @p buf, length of the text string on
+ *                          success
  *
  * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW if @p buf is too small
  * @return              negative on error
  */
-int nanocbor_get_null(nanocbor_value_t *cvalue);
+int nanocbor_get_tstr_concat(nanocbor_value_t *cvalue, uint8_t *buf,
+                             size_t *len);
 
 /**
- * @brief Retrieve a boolean value from the stream
+ * @brief Search for a tstr key in a map.
  *
- * @param[in]   cvalue  CBOR value to decode from
- * @param[out]  value   Boolean value retrieved from the stream
+ * The resulting @p value is undefined if @p key was not found.
  *
- * @return              NANOCBOR_OK on success
- * @return              negative on error
+ * @pre @p start is inside a map
+ *
+ * @param[in]   start   pointer to the map to search
+ * @param[in]   key     pointer to the text string key
+ * @param[out]  value   pointer to the tstr value containing @p key if found
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              negative on error / not found
  */
-int nanocbor_get_bool(nanocbor_value_t *cvalue, bool *value);
+int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
+                          nanocbor_value_t *value);
 
 /**
- * @brief Retrieve a simple value of undefined from the stream
+ * @brief Search for an unsigned integer key in a map
  *
- * @param[in]   cvalue  CBOR value to decode from
+ * The resulting @p value is undefined if @p key was not found. On
+ * deterministically encoded input, see @ref nanocbor_decoder_set_sorted, the
+ * search stops when a key sorted after @p key is found.
  *
- * @return              NANOCBOR_OK on success
- * @return              negative on error
+ * @pre @p start is inside a map
+ *
+ * @param[in]   start   pointer to the map to search
+ * @param[in]   key     integer key
+ * @param[out]  value   pointer to the value of @p key if found
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              NANOCBOR_NOT_FOUND if @p key is not in the map
+ * @return              negative on error
+ */
+int nanocbor_get_key_uint(nanocbor_value_t *start, uint64_t key,
+                          nanocbor_value_t *value);
+
+/**
+ * @brief Search for a signed integer key in a map
+ *
+ * See @ref nanocbor_get_key_uint
+ *
+ * @pre @p start is inside a map
+ *
+ * @param[in]   start   pointer to the map to search
+ * @param[in]   key     integer key
+ * @param[out]  value   pointer to the value of @p key if found
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              NANOCBOR_NOT_FOUND if @p key is not in the map
+ * @return              negative on error
+ */
+int nanocbor_get_key_int(nanocbor_value_t *start, int64_t key,
+                         nanocbor_value_t *value);
+
+/**
+ * @brief Search for multiple tstr keys in a map in a single pass
+ *
+ * Walks the map once and sets @p out[i] to the value of @p keys[i]. Entries of
+ * @p out for keys that are not in the map are set to an empty decoder, for
+ * which @ref nanocbor_at_end returns true. When a key occurs multiple times in
+ * the map, the first occurrence is used. Keys of other types than tstr are
+ * skipped.
+ *
+ * @pre @p start is inside a map
+ *
+ * @param[in]   start   pointer to the map to search
+ * @param[in]   keys    null terminated text string keys to search for
+ * @param[in]   n       number of keys in @p keys
+ * @param[out]  out     array of @p n values, receives the value of each key
+ *
+ * @return              number of keys found
+ * @return              negative on error
+ */
+int nanocbor_get_keys_tstr(const nanocbor_value_t *start,
+                           const char *const keys[], size_t n,
+                           nanocbor_value_t out[]);
+
+/**
+ * @brief Enter a array type
+ *
+ * @param[in]   it      CBOR value to decode from
+ * @param[out]  array   CBOR value to decode the array members with
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_enter_array(const nanocbor_value_t *it, nanocbor_value_t *array);
+
+/**
+ * @brief Enter a map type
+ *
+ * @param[in]   it      CBOR value to decode from
+ * @param[out]  map     CBOR value to decode the map members with
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_enter_map(const nanocbor_value_t *it, nanocbor_value_t *map);
+
+/**
+ * @brief leave the container
+ *
+ * This must be called with the same @ref nanocbor_value_t struct that was used
+ * to enter the container. Furthermore, the @p container must be at the end of
+ * the container.
+ *
+ * @param[in]   it          parent CBOR structure
+ * @param[in]   container   exhausted CBOR container
+ */
+void nanocbor_leave_container(nanocbor_value_t *it,
+                              nanocbor_value_t *container);
+
+/**
+ * @brief Decode an array of unsigned integers into @p values
+ *
+ * Decodes the whole array at the current position in a single call. Runs of
+ * small integers are decoded with a vectorized kernel when
+ * @ref NANOCBOR_USE_SIMD is enabled and the target supports it.
+ *
+ * On error, @p cvalue is not advanced and @p num holds the number of
+ * elements decoded before the error occurred.
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  values  storage for the decoded elements
+ * @param[in]   max     number of elements available in @p values
+ * @param[out]  num     number of elements decoded
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW if the array has more than @p max
+ *                      elements or an element exceeds 32 bit
+ * @return              negative on other errors
+ */
+int nanocbor_get_uint32_array(nanocbor_value_t *cvalue, uint32_t *values,
+                              size_t max, size_t *num);
+
+/**
+ * @brief Decode an array of signed integers into @p values
+ *
+ * See @ref nanocbor_get_uint32_array for the behaviour on errors.
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  values  storage for the decoded elements
+ * @param[in]   max     number of elements available in @p values
+ * @param[out]  num     number of elements decoded
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_int64_array(nanocbor_value_t *cvalue, int64_t *values,
+                             size_t max, size_t *num);
+
+/**
+ * @brief Decode an array of floating point values into @p values
+ *
+ * Elements are decoded as with @ref nanocbor_get_float. See
+ * @ref nanocbor_get_uint32_array for the behaviour on errors.
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  values  storage for the decoded elements
+ * @param[in]   max     number of elements available in @p values
+ * @param[out]  num     number of elements decoded
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_float_array(nanocbor_value_t *cvalue, float *values,
+                             size_t max, size_t *num);
+
+/**
+ * @brief Retrieve the element size of an RFC 8746 typed array tag
+ *
+ * @param[in]   tag     Typed array tag
+ *
+ * @return              Element size in bytes
+ * @return              0 if @p tag is not a typed array tag
+ */
+static inline size_t nanocbor_typed_array_elem_size(uint32_t tag)
+{
+    /* Tag 76 would be a little endian int8_t and is reserved */
+    if (tag < NANOCBOR_TAG_TYPED_ARRAY || tag > NANOCBOR_TAG_TYPED_ARRAY_LAST
+        || tag
+            == (NANOCBOR_TAG_TYPED_SINT8 | NANOCBOR_TYPED_ARRAY_LE)) {
+        return 0;
+    }
+    size_t size = (size_t)1U << (tag & NANOCBOR_TYPED_ARRAY_SIZE_MASK);
+    return tag & NANOCBOR_TYPED_ARRAY_FLOAT ? size * 2 : size;
+}
+
+/**
+ * @brief Retrieve an RFC 8746 typed array from the stream
+ *
+ * Decodes a typed array tag and the byte string holding the elements. The
+ * element data is not copied, @p array points into the decoded buffer. Use
+ * @ref nanocbor_typed_array_elements to access the elements in host byte
+ * order.
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  array   typed array view
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_INVALID_TYPE if the value is not a typed
+ *                      array or the data is not a multiple of the element size
+ * @return              negative on other errors
+ */
+int nanocbor_get_typed_array(nanocbor_value_t *cvalue,
+                             nanocbor_typed_array_t *array);
+
+/**
+ * @brief Access the elements of a typed array in host byte order
+ *
+ * Returns a pointer into the decoded buffer when the byte order of the
+ * elements matches the host and the data is suitably aligned. Otherwise the
+ * elements are copied into @p buf, byte swapped when required.
+ *
+ * @param[in]   array   typed array view
+ * @param[in]   buf     buffer for the converted elements, suitably aligned
+ * @param[in]   buf_len length of @p buf in bytes
+ *
+ * @return              pointer to the elements in host byte order
+ * @return              NULL if a copy is required and @p buf is too small
+ */
+const void *nanocbor_typed_array_elements(const nanocbor_typed_array_t *array,
+                                          void *buf, size_t buf_len);
+
+/**
+ * @brief Retrieve a tag as positive uint32_t from the stream
+ *
+ * The resulting @p value is undefined if the result is an error condition
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  tag     returned tag as positive integer
+ *
+ * @return              NANOCBOR_OK on success
+ */
+int nanocbor_get_tag(nanocbor_value_t *cvalue, uint32_t *tag);
+
+/**
+ * @brief Retrieve a null value from the stream
+ *
+ * This function checks if the next CBOR value is a NULL value and advances to
+ * the next value if no error is detected
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_null(nanocbor_value_t *cvalue);
+
+/**
+ * @brief Retrieve a boolean value from the stream
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  value   Boolean value retrieved from the stream
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_bool(nanocbor_value_t *cvalue, bool *value);
+
+/**
+ * @brief Retrieve a simple value of undefined from the stream
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
  */
 int nanocbor_get_undefined(nanocbor_value_t *cvalue);
 
@@ -538,165 +1319,780 @@ int nanocbor_get_undefined(nanocbor_value_t *cvalue);
  * This function returns the simple value as uint8_t value and skips decoding
  * the meaning of the values. For example, a CBOR true is returned as value 21.
  *
- * @param[in]   cvalue  CBOR value to decode from
- * @param[out]  value   Simple value retrieved from the stream
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  value   Simple value retrieved from the stream
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_simple(nanocbor_value_t *cvalue, uint8_t *value);
+
+/**
+ * @brief Retrieve a float value from the stream.
+ *
+ * This function automatically converts CBOR half floats into 32 bit floating
+ * points.
+ *
+ * @note This function assumes the host uses ieee754 to represent floating point
+ * numbers
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  value   Simple value retrieved from the stream
+ *
+ * @return              number of bytes read on success
+ * @return              negative on error
+ */
+int nanocbor_get_float(nanocbor_value_t *cvalue, float *value);
+
+/**
+ * @brief Retrieve a double-sized floating point value from the stream.
+ *
+ * This function automatically converts CBOR half floats and 32 bit floats into
+ * into 64 bit floating points.
+ *
+ * @note This function assumes the host uses ieee754 to represent floating point
+ * numbers
+ *
+ * @param[in]   cvalue  CBOR value to decode from
+ * @param[out]  value   Simple value retrieved from the stream
+ *
+ * @return              number of bytes read on success
+ * @return              negative on error
+ */
+int nanocbor_get_double(nanocbor_value_t *cvalue, double *value);
+
+/**
+ * @brief Skip to the next value in the CBOR stream
+ *
+ * This function is able to skip over nested structures in the CBOR stream
+ * such as (nested) arrays and maps. A tag is skipped together with the tagged
+ * value.
+ *
+ * Nesting is limited with @ref NANOCBOR_RECURSION_MAX, use
+ * @ref nanocbor_skip_stack to skip deeper nested structures.
+ *
+ * @param[in]   it  CBOR stream to skip a value from
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_skip(nanocbor_value_t *it);
+
+/**
+ * @brief Skip to the next value in the CBOR stream using a caller supplied
+ *        stack
+ *
+ * Same as @ref nanocbor_skip, but the nesting depth is limited by the number
+ * of entries in @p stack instead of @ref NANOCBOR_RECURSION_MAX. The function
+ * does not recurse, the C stack usage is independent of the nesting depth.
+ *
+ * @param[in]   it      CBOR stream to skip a value from
+ * @param[in]   stack   Stack storage, one entry per nesting level
+ * @param[in]   depth   Number of entries in @p stack
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_RECURSION if @p depth is exceeded
+ * @return              negative on other errors
+ */
+int nanocbor_skip_stack(nanocbor_value_t *it, nanocbor_stack_entry_t *stack,
+                        size_t depth);
+
+/**
+ * @brief Check that @p buf contains only well-formed CBOR
+ *
+ * Checks all well-formedness requirements of RFC 8949 in a single pass:
+ * truncated items, reserved additional information values, indefinite
+ * lengths on major types that do not allow them, misplaced break markers,
+ * simple values below 32 in the two byte encoding and chunks of indefinite
+ * length strings with the wrong type. Multiple top level items are checked
+ * as a CBOR sequence. Nesting is limited to @ref NANOCBOR_RECURSION_MAX
+ * levels, use @ref nanocbor_validate_stack for deeper nesting.
+ *
+ * With @ref NANOCBOR_VALIDATE_FLAG_UTF8, text strings must also be valid
+ * UTF-8.
+ *
+ * @param[in]   buf     Buffer to check
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[in]   flags   Validation flags
+ * @param[out]  offset  Offset of the first malformed item on error, @p len on
+ *                      success, may be NULL
+ *
+ * @return              NANOCBOR_OK if @p buf is well-formed
+ * @return              NANOCBOR_ERR_END if an item is truncated
+ * @return              NANOCBOR_ERR_INVALID_TYPE if an item is malformed
+ * @return              NANOCBOR_ERR_INVALID_UTF8 if a text string is not
+ *                      valid UTF-8
+ * @return              NANOCBOR_ERR_RECURSION if the nesting is too deep
+ */
+int nanocbor_validate(const uint8_t *buf, size_t len, uint8_t flags,
+                      size_t *offset);
+
+/**
+ * @brief Check that @p buf contains only well-formed CBOR using a caller
+ *        supplied stack
+ *
+ * See @ref nanocbor_validate, the nesting depth is limited by @p depth.
+ *
+ * @param[in]   buf     Buffer to check
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[in]   flags   Validation flags
+ * @param[out]  offset  Offset of the first malformed item on error, @p len on
+ *                      success, may be NULL
+ * @param[in]   stack   Stack storage, one entry per nesting level
+ * @param[in]   depth   Number of entries in @p stack
+ *
+ * @return              NANOCBOR_OK if @p buf is well-formed
+ * @return              negative on error, see @ref nanocbor_validate
+ */
+int nanocbor_validate_stack(const uint8_t *buf, size_t len, uint8_t flags,
+                            size_t *offset, nanocbor_stack_entry_t *stack,
+                            size_t depth);
+
+/**
+ * @brief Check that @p buf uses core deterministic encoding
+ *
+ * Checks the requirements of RFC 8949 section 4.2.1 in a single pass
+ * together with well-formedness: integers, lengths and tags use the shortest
+ * header, floating point values use the shortest precision that preserves
+ * the value, no indefinite lengths are used and map keys are unique and
+ * sorted bytewise by their encoding. Nesting is limited to
+ * @ref NANOCBOR_RECURSION_MAX levels, use
+ * @ref nanocbor_check_deterministic_stack for deeper nesting.
+ *
+ * @param[in]   buf     Buffer to check
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[out]  offset  Offset of the first offending item or map key on
+ *                      error, @p len on success, may be NULL
+ *
+ * @return              NANOCBOR_OK if @p buf is deterministically encoded
+ * @return              NANOCBOR_ERR_NOT_DETERMINISTIC if an item is not
+ * @return              negative on other errors, see @ref nanocbor_validate
+ */
+int nanocbor_check_deterministic(const uint8_t *buf, size_t len,
+                                 size_t *offset);
+
+/**
+ * @brief Check that @p buf uses core deterministic encoding using a caller
+ *        supplied stack
+ *
+ * See @ref nanocbor_check_deterministic, the nesting depth is limited by
+ * @p depth.
+ *
+ * @param[in]   buf     Buffer to check
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[out]  offset  Offset of the first offending item or map key on
+ *                      error, @p len on success, may be NULL
+ * @param[in]   stack   Stack storage, one entry per nesting level
+ * @param[in]   depth   Number of entries in @p stack
+ *
+ * @return              NANOCBOR_OK if @p buf is deterministically encoded
+ * @return              negative on error, see
+ *                      @ref nanocbor_check_deterministic
+ */
+int nanocbor_check_deterministic_stack(const uint8_t *buf, size_t len,
+                                       size_t *offset,
+                                       nanocbor_det_entry_t *stack,
+                                       size_t depth);
+
+/**
+ * @brief Skip a single simple value in the CBOR stream
+ *
+ * This is a cheaper version of @ref nanocbor_skip, the downside is that this
+ * function is unable to skip nested structures.
+ *
+ * @param[in]   it  CBOR value to skip
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_skip_simple(nanocbor_value_t *it);
+
+/**
+ * @brief Retrieve part of the CBOR stream for separate parsing
+ *
+ * This function retrieves the pointer and length of a single CBOR item. This
+ * item can be stored for later processing.
+ *
+ * @param[in]   it      CBOR value to retrieve
+ * @param[out]  start   start of the CBOR item
+ * @param[out]  len     length of the CBOR item
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_get_subcbor(nanocbor_value_t *it, const uint8_t **start,
+                         size_t *len);
+
+/**
+ * @brief Retrieve the number of remaining values in a CBOR container: either array or map
+ *
+ * The returned value is undefined when not inside a container or when the
+ * container is of indefinite length. For a map, the number is the full number
+ * of CBOR items remaining (twice the number of key/value pairs).
+ *
+ * See also nanocbor_array_items_remaining and nanocbor_map_items_remaining
+ *
+ * @param[in]   value   value inside a CBOR container
+ *
+ * @return              number of items remaining
+ */
+static inline uint32_t
+nanocbor_container_remaining(const nanocbor_value_t *value)
+{
+    return value->remaining;
+}
+
+/**
+ * @brief Retrieve the number of remaining items in a CBOR array
+ *
+ * The returned value is undefined when not inside an array or when the
+ * array is of indefinite length.
+ *
+ * @param[in]   value   nanocbor value inside a CBOR array
+ *
+ * @return              number of array items remaining
+ */
+static inline uint32_t
+nanocbor_array_items_remaining(const nanocbor_value_t *value)
+{
+    return nanocbor_container_remaining(value);
+}
+
+/**
+ * @brief Retrieve the number of remaining values in a CBOR map
+ *
+ * The returned value is undefined when not inside a map or when the
+ * container is of indefinite length.
+ *
+ * @param[in]   value   nanocbor value inside a CBOR map
+ *
+ * @return              number of key/value pairs remaining
+ */
+static inline uint32_t
+nanocbor_map_items_remaining(const nanocbor_value_t *value)
+{
+    return nanocbor_container_remaining(value)/2;
+}
+
+/**
+ * @brief Check whether a container is an indefinite-length container
+ *
+ * @param[in]   container   value inside a CBOR container
+ *
+ * @return                  True when the container is indefinite in length
+ * @return                  False when not indefinite-length or not in a
+ *                          container
+ */
+static inline bool
+nanocbor_container_indefinite(const nanocbor_value_t *container)
+{
+    return (container->flags
+            & (NANOCBOR_DECODER_FLAG_INDEFINITE
+               | NANOCBOR_DECODER_FLAG_CONTAINER))
+        == (NANOCBOR_DECODER_FLAG_INDEFINITE | NANOCBOR_DECODER_FLAG_CONTAINER);
+}
+
+static inline bool nanocbor_in_container(const nanocbor_value_t *container)
+{
+    return container->flags & (NANOCBOR_DECODER_FLAG_CONTAINER);
+}
+
+/** @} */
+
+/**
+ * @name NanoCBOR structural index functions
+ *
+ * The structural index is an optional pre-pass over a CBOR buffer. It records
+ * the position, type, argument and end of every item in a caller supplied
+ * table. Afterwards, skipping over items, including nested containers, no
+ * longer requires walking over the bytes of the skipped items.
+ * @{
+ */
+
+/**
+ * @brief Initialize a structural index with caller supplied entry storage
+ *
+ * @param[out]  index       Index to initialize
+ * @param[in]   entries     Storage for the index entries
+ * @param[in]   num_entries Number of entries in @p entries
+ */
+void nanocbor_index_init(nanocbor_index_t *index,
+                         nanocbor_index_entry_t *entries, size_t num_entries);
+
+/**
+ * @brief Build the structural index of @p buf
+ *
+ * Every CBOR item in the buffer, including nested items, receives one entry.
+ * Entries are stored in the order the items appear in the buffer. The break
+ * markers of indefinite length items don't receive an entry. The build does
+ * not recurse and has no nesting limit.
+ *
+ * @param[in]   index   Initialized index
+ * @param[in]   buf     Buffer to index
+ * @param[in]   len     Length in bytes of the buffer
+ *
+ * @return              Number of entries on success
+ * @return              NANOCBOR_ERR_OVERFLOW if the entry storage is too small
+ * @return              negative on other errors
+ */
+int nanocbor_index_build(nanocbor_index_t *index, const uint8_t *buf,
+                         size_t len);
+
+/**
+ * @brief Retrieve the index entry of the item starting at @p pos
+ *
+ * @param[in]   index   Built index
+ * @param[in]   pos     Start of an item inside the indexed buffer
+ *
+ * @return              The index entry of the item
+ * @return              NULL if no item starts at @p pos
+ */
+const nanocbor_index_entry_t *nanocbor_index_lookup(nanocbor_index_t *index,
+                                                    const uint8_t *pos);
+
+/**
+ * @brief Skip to the next value using the structural index
+ *
+ * Equivalent to @ref nanocbor_skip, but nested structures are skipped with a
+ * single table lookup. Falls back to @ref nanocbor_skip if @p it is not
+ * positioned inside the indexed buffer.
+ *
+ * @param[in]   index   Built index of the buffer decoded by @p it
+ * @param[in]   it      CBOR stream to skip a value from
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_index_skip(nanocbor_index_t *index, nanocbor_value_t *it);
+
+/**
+ * @brief Skip @p n values using the structural index
+ *
+ * Can be used to jump to element N of an array after entering it. The cost is
+ * linear in @p n: the entries only link to their next sibling, so every
+ * skipped value is one step through the table. No bytes are decoded and only
+ * the first value is looked up.
+ *
+ * @param[in]   index   Built index of the buffer decoded by @p it
+ * @param[in]   it      CBOR stream to skip the values from
+ * @param[in]   n       Number of values to skip
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_index_skip_items(nanocbor_index_t *index, nanocbor_value_t *it,
+                              size_t n);
+
+/**
+ * @brief Search for a tstr key in a map using the structural index
+ *
+ * Same as @ref nanocbor_get_key_tstr, but map values are skipped using the
+ * structural index.
+ *
+ * @pre @p start is inside a map
+ *
+ * @param[in]   index   Built index of the buffer decoded by @p start
+ * @param[in]   start   pointer to the map to search
+ * @param[in]   key     pointer to the text string key
+ * @param[out]  value   pointer to the tstr value containing @p key if found
+ *
+ * @return              NANOCBOR_OK if @p key was found
+ * @return              negative on error / not found
+ */
+int nanocbor_index_get_key_tstr(nanocbor_index_t *index,
+                                nanocbor_value_t *start, const char *key,
+                                nanocbor_value_t *value);
+
+/** @} */
+
+/**
+ * @name NanoCBOR event parser functions
+ * @{
+ */
+
+/**
+ * @brief Parse all items in @p buf, firing a callback for every item
+ *
+ * The document is walked iteratively, nesting is limited to
+ * @ref NANOCBOR_RECURSION_MAX levels. Multiple top level items are parsed as
+ * a CBOR sequence.
+ *
+ * @param[in]   buf     Buffer to parse
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[in]   cb      Callbacks to fire
+ * @param[in]   ctx     Context passed to the callbacks
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error or the negative return value of a
+ *                      callback
+ */
+int nanocbor_parse_events(const uint8_t *buf, size_t len,
+                          const nanocbor_callbacks_t *cb, void *ctx);
+
+/**
+ * @brief Parse all items in @p buf using a caller supplied stack
+ *
+ * See @ref nanocbor_parse_events, nesting is limited by @p depth instead.
+ *
+ * @param[in]   buf     Buffer to parse
+ * @param[in]   len     Length of @p buf in bytes
+ * @param[in]   cb      Callbacks to fire
+ * @param[in]   ctx     Context passed to the callbacks
+ * @param[in]   stack   Stack storage for the open containers
+ * @param[in]   depth   Number of entries in @p stack
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_RECURSION if the nesting exceeds @p depth
+ * @return              negative on error or the negative return value of a
+ *                      callback
+ */
+int nanocbor_parse_events_stack(const uint8_t *buf, size_t len,
+                                const nanocbor_callbacks_t *cb, void *ctx,
+                                nanocbor_stack_entry_t *stack, size_t depth);
+/** @} */
+
+/**
+ * @name NanoCBOR struct binding functions
+ * @{
+ */
+
+/**
+ * @brief Decode a map into a struct in a single pass
+ *
+ * Every map entry with a key in @p desc is decoded into the member of @p out
+ * described by the field, entries with other keys are skipped. When a key
+ * occurs multiple times, the first occurrence is used. Members of fields
+ * that are not in the map are left untouched. The value is only advanced on
+ * success, on error the contents of @p out are undefined.
+ *
+ * @param[in]   it      CBOR value to decode the map from
+ * @param[in]   desc    Description of the struct
+ * @param[out]  out     Struct to decode into
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_NOT_FOUND when a required field is missing
+ * @return              NANOCBOR_ERR_OVERFLOW when @p desc has more than
+ *                      @ref NANOCBOR_STRUCT_FIELDS_MAX fields
+ * @return              negative on error
+ */
+int nanocbor_get_struct(nanocbor_value_t *it, const nanocbor_struct_t *desc,
+                        void *out);
+
+/**
+ * @brief Hash of a text string key, as used by the struct perfect hash table
+ *
+ * @param[in]   seed    Seed of the perfect hash function
+ * @param[in]   key     Text string key
+ * @param[in]   len     Length of @p key in bytes
+ *
+ * @return              Hash of the key
+ */
+uint32_t nanocbor_struct_hash_tstr(uint32_t seed, const uint8_t *key,
+                                   size_t len);
+
+/**
+ * @brief Hash of an integer key, as used by the struct perfect hash table
+ *
+ * @param[in]   seed    Seed of the perfect hash function
+ * @param[in]   key     Integer key
+ *
+ * @return              Hash of the key
+ */
+uint32_t nanocbor_struct_hash_int(uint32_t seed, int64_t key);
+
+/**
+ * @brief Check a map for duplicate keys
+ *
+ * Keys are compared on their encoded bytes, as retrieved by
+ * @ref nanocbor_get_subcbor. Each key is hashed into the caller provided open
+ * addressing table in @p table, taking linear expected time. Once a map has
+ * more than @p size / 2 keys, the keys are sorted in @p table instead. The
+ * contents of @p table are undefined afterwards.
+ *
+ * @param[in]   it      CBOR value pointing at the map to check
+ * @param[in]   table   Key slot storage
+ * @param[in]   size    Number of slots in @p table, at least one per key
+ *
+ * @return              NANOCBOR_OK when all keys are unique
+ * @return              NANOCBOR_ERR_DUPLICATE_KEY when a key occurs twice
+ * @return              NANOCBOR_ERR_OVERFLOW when the map has more than
+ *                      @p size keys
+ * @return              negative on other errors
+ */
+int nanocbor_check_map_keys(const nanocbor_value_t *it,
+                            nanocbor_key_slot_t *table, size_t size);
+/** @} */
+
+/**
+ * @name NanoCBOR scatter-gather decoder functions
+ *
+ * Decode CBOR that is split over a list of segments, such as a chain of
+ * network buffers, without first copying it into a single buffer. Headers
+ * and strings may straddle segment boundaries.
+ * @{
+ */
+
+/**
+ * @brief Initialize a decoder context over a list of segments
+ *
+ * @param[out]  it      Decoder context
+ * @param[in]   segs    Segments, in order
+ * @param[in]   num     Number of segments
+ */
+void nanocbor_seg_decoder_init(nanocbor_seg_value_t *it,
+                               const nanocbor_iovec_t *segs, size_t num);
+
+/**
+ * @brief Check whether a container or the segments are exhausted
+ *
+ * @param[in]   it      Decoder context
+ *
+ * @return              True when no items are left
+ */
+bool nanocbor_seg_at_end(const nanocbor_seg_value_t *it);
+
+/**
+ * @brief Decode the header of the next item without consuming it
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  header  Decoded header
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_seg_peek_header(const nanocbor_seg_value_t *it,
+                             nanocbor_header_t *header);
+
+/**
+ * @brief Consume an item that is fully described by its header
+ *
+ * See @ref nanocbor_advance_header.
+ *
+ * @param[in]   it      Decoder context
+ * @param[in]   header  Header retrieved with @ref nanocbor_seg_peek_header
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_seg_advance_header(nanocbor_seg_value_t *it,
+                                const nanocbor_header_t *header);
+
+/**
+ * @brief Retrieve an unsigned integer
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  value   Decoded integer
+ *
+ * @return              number of bytes read
+ * @return              negative on error
+ */
+int nanocbor_seg_get_uint64(nanocbor_seg_value_t *it, uint64_t *value);
+
+/**
+ * @brief Retrieve a signed integer
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  value   Decoded integer
+ *
+ * @return              number of bytes read
+ * @return              NANOCBOR_ERR_OVERFLOW if the value does not fit
+ * @return              negative on error
+ */
+int nanocbor_seg_get_int64(nanocbor_seg_value_t *it, int64_t *value);
+
+/**
+ * @brief Retrieve a tag, the tagged item follows
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  tag     Decoded tag
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_seg_get_tag(nanocbor_seg_value_t *it, uint32_t *tag);
+
+/**
+ * @brief Retrieve a byte string
+ *
+ * A string within a single segment is returned as a pointer into the
+ * segment. A string straddling segments is copied into @p scratch.
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  buf     Start of the string
+ * @param[out]  len     Length of the string
+ * @param[in]   scratch Buffer for strings straddling segments
+ * @param[in]   size    Size of @p scratch
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW if a straddling string does not
+ *                      fit @p scratch
+ * @return              negative on error
+ */
+int nanocbor_seg_get_bstr(nanocbor_seg_value_t *it, const uint8_t **buf,
+                          size_t *len, uint8_t *scratch, size_t size);
+
+/**
+ * @brief Retrieve a text string
+ *
+ * See @ref nanocbor_seg_get_bstr.
+ *
+ * @param[in]   it      Decoder context
+ * @param[out]  buf     Start of the string
+ * @param[out]  len     Length of the string
+ * @param[in]   scratch Buffer for strings straddling segments
+ * @param[in]   size    Size of @p scratch
  *
  * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_OVERFLOW if a straddling string does not
+ *                      fit @p scratch
  * @return              negative on error
  */
-int nanocbor_get_simple(nanocbor_value_t *cvalue, uint8_t *value);
+int nanocbor_seg_get_tstr(nanocbor_seg_value_t *it, const uint8_t **buf,
+                          size_t *len, uint8_t *scratch, size_t size);
 
 /**
- * @brief Retrieve a float value from the stream.
+ * @brief Retrieve a floating point value as float
  *
- * This function automatically converts CBOR half floats into 32 bit floating
- * points.
- *
- * @note This function assumes the host uses ieee754 to represent floating point
- * numbers
+ * See @ref nanocbor_get_float.
  *
- * @param[in]   cvalue  CBOR value to decode from
- * @param[out]  value   Simple value retrieved from the stream
+ * @param[in]   it      Decoder context
+ * @param[out]  value   Decoded value
  *
  * @return              number of bytes read on success
  * @return              negative on error
  */
-int nanocbor_get_float(nanocbor_value_t *cvalue, float *value);
+int nanocbor_seg_get_float(nanocbor_seg_value_t *it, float *value);
 
 /**
- * @brief Retrieve a double-sized floating point value from the stream.
- *
- * This function automatically converts CBOR half floats and 32 bit floats into
- * into 64 bit floating points.
+ * @brief Retrieve a floating point value as double
  *
- * @note This function assumes the host uses ieee754 to represent floating point
- * numbers
+ * See @ref nanocbor_get_double.
  *
- * @param[in]   cvalue  CBOR value to decode from
- * @param[out]  value   Simple value retrieved from the stream
+ * @param[in]   it      Decoder context
+ * @param[out]  value   Decoded value
  *
  * @return              number of bytes read on success
  * @return              negative on error
  */
-int nanocbor_get_double(nanocbor_value_t *cvalue, double *value);
+int nanocbor_seg_get_double(nanocbor_seg_value_t *it, double *value);
 
 /**
- * @brief Skip to the next value in the CBOR stream
- *
- * This function is able to skip over nested structures in the CBOR stream
- * such as (nested) arrays and maps. It uses limited recursion to do so.
+ * @brief Retrieve a boolean value
  *
- * Recursion is limited with @ref NANOCBOR_RECURSION_MAX
- *
- * @param[in]   it  CBOR stream to skip a value from
+ * @param[in]   it      Decoder context
+ * @param[out]  value   Decoded value
  *
  * @return              NANOCBOR_OK on success
  * @return              negative on error
  */
-int nanocbor_skip(nanocbor_value_t *it);
+int nanocbor_seg_get_bool(nanocbor_seg_value_t *it, bool *value);
 
 /**
- * @brief Skip a single simple value in the CBOR stream
+ * @brief Retrieve a null value
  *
- * This is a cheaper version of @ref nanocbor_skip, the downside is that this
- * function is unable to skip nested structures.
- *
- * @param[in]   it  CBOR value to skip
+ * @param[in]   it      Decoder context
  *
  * @return              NANOCBOR_OK on success
  * @return              negative on error
  */
-int nanocbor_skip_simple(nanocbor_value_t *it);
+int nanocbor_seg_get_null(nanocbor_seg_value_t *it);
 
 /**
- * @brief Retrieve part of the CBOR stream for separate parsing
- *
- * This function retrieves the pointer and length of a single CBOR item. This
- * item can be stored for later processing.
+ * @brief Enter an array
  *
- * @param[in]   it      CBOR value to retrieve
- * @param[out]  start   start of the CBOR item
- * @param[out]  len     length of the CBOR item
+ * @param[in]   it      Decoder context
+ * @param[out]  array   Decoder context for the array
  *
  * @return              NANOCBOR_OK on success
  * @return              negative on error
  */
-int nanocbor_get_subcbor(nanocbor_value_t *it, const uint8_t **start,
-                         size_t *len);
+int nanocbor_seg_enter_array(const nanocbor_seg_value_t *it,
+                             nanocbor_seg_value_t *array);
 
 /**
- * @brief Retrieve the number of remaining values in a CBOR container: either array or map
- *
- * The returned value is undefined when not inside a container or when the
- * container is of indefinite length. For a map, the number is the full number
- * of CBOR items remaining (twice the number of key/value pairs).
+ * @brief Enter a map
  *
- * See also nanocbor_array_items_remaining and nanocbor_map_items_remaining
+ * @param[in]   it      Decoder context
+ * @param[out]  map     Decoder context for the map
  *
- * @param[in]   value   value inside a CBOR container
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
+ */
+int nanocbor_seg_enter_map(const nanocbor_seg_value_t *it,
+                           nanocbor_seg_value_t *map);
+
+/**
+ * @brief Leave a container, which must be at its end
  *
- * @return              number of items remaining
+ * @param[in]   it          Decoder context of the parent
+ * @param[in]   container   Decoder context of the container
  */
-static inline uint32_t
-nanocbor_container_remaining(const nanocbor_value_t *value)
-{
-    return value->remaining;
-}
+void nanocbor_seg_leave_container(nanocbor_seg_value_t *it,
+                                  nanocbor_seg_value_t *container);
 
 /**
- * @brief Retrieve the number of remaining items in a CBOR array
+ * @brief Skip a single item, including nested items
  *
- * The returned value is undefined when not inside an array or when the
- * array is of indefinite length.
+ * Nesting is limited to @ref NANOCBOR_RECURSION_MAX levels, use
+ * @ref nanocbor_seg_skip_stack for deeper nesting.
  *
- * @param[in]   value   nanocbor value inside a CBOR array
+ * @param[in]   it      Decoder context
  *
- * @return              number of array items remaining
+ * @return              NANOCBOR_OK on success
+ * @return              negative on error
  */
-static inline uint32_t
-nanocbor_array_items_remaining(const nanocbor_value_t *value)
-{
-    return nanocbor_container_remaining(value);
-}
+int nanocbor_seg_skip(nanocbor_seg_value_t *it);
 
 /**
- * @brief Retrieve the number of remaining values in a CBOR map
+ * @brief Skip a single item using a caller supplied stack
  *
- * The returned value is undefined when not inside a map or when the
- * container is of indefinite length.
+ * Same as @ref nanocbor_seg_skip, but the nesting depth is limited by the
+ * number of entries in @p stack instead of @ref NANOCBOR_RECURSION_MAX.
  *
- * @param[in]   value   nanocbor value inside a CBOR map
+ * @param[in]   it      Decoder context
+ * @param[in]   stack   Stack storage, one entry per nesting level
+ * @param[in]   depth   Number of entries in @p stack
  *
- * @return              number of key/value pairs remaining
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_RECURSION if @p depth is exceeded
+ * @return              negative on other errors
  */
-static inline uint32_t
-nanocbor_map_items_remaining(const nanocbor_value_t *value)
-{
-    return nanocbor_container_remaining(value)/2;
-}
+int nanocbor_seg_skip_stack(nanocbor_seg_value_t *it,
+                            nanocbor_stack_entry_t *stack, size_t depth);
+/** @} */
 
 /**
- * @brief Check whether a container is an indefinite-length container
- *
- * @param[in]   container   value inside a CBOR container
+ * @name Encoded sizes
  *
- * @return                  True when the container is indefinite in length
- * @return                  False when not indefinite-length or not in a
- *                          container
+ * Usable in constant expressions, arguments may be evaluated more than once.
+ * @{
  */
-static inline bool
-nanocbor_container_indefinite(const nanocbor_value_t *container)
-{
-    return (container->flags
-            == (NANOCBOR_DECODER_FLAG_INDEFINITE
-                | NANOCBOR_DECODER_FLAG_CONTAINER));
-}
+#define NANOCBOR_ENCODED_SIZE_HEADER_MAX (9U) /**< Largest header */
 
-static inline bool nanocbor_in_container(const nanocbor_value_t *container)
-{
-    return container->flags & (NANOCBOR_DECODER_FLAG_CONTAINER);
-}
+/** @brief Header with argument @p n, such as an integer or a length */
+#define NANOCBOR_ENCODED_SIZE_ARG(n)                                           \
+    ((uint64_t)(n) < NANOCBOR_SIZE_BYTE                                        \
+         ? 1U                                                                  \
+         : ((uint64_t)(n) <= UINT8_MAX                                         \
+                ? 2U                                                           \
+                : ((uint64_t)(n) <= UINT16_MAX                                 \
+                       ? 3U                                                    \
+                       : ((uint64_t)(n) <= UINT32_MAX ? 5U : 9U))))
 
+/** @brief Unsigned integer @p n */
+#define NANOCBOR_ENCODED_SIZE_UINT(n) NANOCBOR_ENCODED_SIZE_ARG(n)
+
+/** @brief Signed integer @p n */
+#define NANOCBOR_ENCODED_SIZE_INT(n)                                           \
+    ((n) < 0 ? NANOCBOR_ENCODED_SIZE_ARG(-((n) + 1))                           \
+             : NANOCBOR_ENCODED_SIZE_ARG(n))
+
+/** @brief Byte or text string of @p len bytes */
+#define NANOCBOR_ENCODED_SIZE_STR(len) (NANOCBOR_ENCODED_SIZE_ARG(len) + (len))
+
+#define NANOCBOR_ENCODED_SIZE_SIMPLE (1U) /**< Boolean, null or undefined */
+#define NANOCBOR_ENCODED_SIZE_FLOAT_MAX (5U) /**< Largest float */
+#define NANOCBOR_ENCODED_SIZE_DOUBLE_MAX (9U) /**< Largest double */
 /** @} */
 
 /**
@@ -728,6 +2124,158 @@ void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
                                   nanocbor_encoder_append append_func,
                                   nanocbor_encoder_fits fits_func);
 
+/**
+ * @brief Initializes an encoder context with a growable buffer
+ *
+ * The buffer grows geometrically through @p realloc_func as data is
+ * appended, starting at @ref NANOCBOR_GROWBUF_MIN bytes. Encoding only fails
+ * with NANOCBOR_ERR_END when the allocator fails.
+ *
+ * @param[in]   enc             Encoder context
+ * @param[out]  grow            Growable buffer
+ * @param[in]   realloc_func    Allocator, NULL to use realloc(3)
+ * @param[in]   ctx             Context ptr passed to @p realloc_func
+ */
+void nanocbor_encoder_growable_init(nanocbor_encoder_t *enc,
+                                    nanocbor_growbuf_t *grow,
+                                    nanocbor_realloc_t realloc_func, void *ctx);
+
+/**
+ * @brief Initializes a streaming encoder context with a staging buffer
+ *
+ * Encoded data is collected in @p buf and passed to @p append_func in blocks
+ * of up to @p size bytes, instead of calling the user functions for every
+ * header and payload. Payloads larger than @p buf are passed on directly.
+ * Call @ref nanocbor_encoder_flush after encoding to pass on the remaining
+ * staged data.
+ *
+ * @p fits_func is only called when staged data is passed on, so a sink that
+ * can not take more data is not reported by the `nanocbor_fmt_*` call that
+ * wrote the data. The error is deferred to the first later
+ * `nanocbor_fmt_*` call that needs to pass on the staged data, or to
+ * @ref nanocbor_encoder_flush. The return value of the final
+ * @ref nanocbor_encoder_flush must always be checked, it is the only report
+ * for data staged by the last calls.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[out]  stream      Staging buffer context
+ * @param[in]   buf         Staging buffer
+ * @param[in]   size        Size of @p buf in bytes
+ * @param[in]   ctx         Context pointer
+ * @param[in]   append_func Called to append emitted encoder data
+ * @param[in]   fits_func   Called to check if data can be consumed
+ */
+void nanocbor_encoder_buffered_init(nanocbor_encoder_t *enc,
+                                    nanocbor_stream_buf_t *stream,
+                                    uint8_t *buf, size_t size, void *ctx,
+                                    nanocbor_encoder_append append_func,
+                                    nanocbor_encoder_fits fits_func);
+
+/**
+ * @brief Pass staged data of a buffered encoder on to the user functions
+ *
+ * Does nothing for encoders not initialized with
+ * @ref nanocbor_encoder_buffered_init. Errors of the user fits function for
+ * staged data surface here, the return value must be checked after the last
+ * item is encoded.
+ *
+ * @param[in]   enc     Encoder context
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END when the user fits function fails
+ */
+int nanocbor_encoder_flush(nanocbor_encoder_t *enc);
+
+/**
+ * @brief Initializes an encoder context with vectored output
+ *
+ * Headers and payloads smaller than @p threshold bytes are copied into
+ * @p buf, larger payloads are referenced in @p iov without copying them.
+ * Consecutive copied data shares a single vector. The first @p vec->num
+ * vectors of @p iov can be passed to writev(2) after encoding, referenced
+ * payloads must stay valid until then.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[out]  vec         Vectored output context
+ * @param[in]   iov         Output vectors
+ * @param[in]   max         Number of vectors in @p iov
+ * @param[in]   buf         Storage for copied data
+ * @param[in]   size        Size of @p buf in bytes
+ * @param[in]   threshold   Size from which payloads are referenced, raised
+ *                          to @ref NANOCBOR_IOVEC_THRESHOLD_MIN if smaller
+ */
+void nanocbor_encoder_iovec_init(nanocbor_encoder_t *enc,
+                                 nanocbor_iovec_buf_t *vec,
+                                 nanocbor_iovec_t *iov, size_t max,
+                                 uint8_t *buf, size_t size, size_t threshold);
+
+/**
+ * @brief Initializes an encoder context that only computes the encoded length
+ *
+ * Nothing is written and every write succeeds, @ref nanocbor_encoded_len
+ * returns the size required for the encoded items. Cheaper than encoding
+ * into a `NULL` buffer.
+ *
+ * @param[in]   enc     Encoder context
+ */
+void nanocbor_encoder_size_init(nanocbor_encoder_t *enc);
+
+/**
+ * @brief Encoded size of an unsigned integer
+ *
+ * @param[in]   num     unsigned integer
+ *
+ * @return              Size in bytes
+ */
+size_t nanocbor_size_uint(uint64_t num);
+
+/**
+ * @brief Encoded size of a signed integer
+ *
+ * @param[in]   num     signed integer
+ *
+ * @return              Size in bytes
+ */
+size_t nanocbor_size_int(int64_t num);
+
+/**
+ * @brief Encoded size of a byte or text string
+ *
+ * @param[in]   len     Length of the string in bytes
+ *
+ * @return              Size in bytes, including the header
+ */
+size_t nanocbor_size_str(size_t len);
+
+/**
+ * @brief Encoded size of a float, as written by @ref nanocbor_fmt_float
+ *
+ * @param[in]   num     Floating point value
+ *
+ * @return              Size in bytes
+ */
+size_t nanocbor_size_float(float num);
+
+/**
+ * @brief Encoded size of a double, as written by @ref nanocbor_fmt_double
+ *
+ * @param[in]   num     Floating point value
+ *
+ * @return              Size in bytes
+ */
+size_t nanocbor_size_double(double num);
+
+/**
+ * @brief Restrict the encoder to deterministic encoding
+ *
+ * Sets @ref NANOCBOR_ENCODER_FLAG_CANONICAL: writing an indefinite length
+ * item afterwards fails with NANOCBOR_ERR_INVALID_TYPE. Integers, lengths
+ * and floating point values are always encoded in their shortest form.
+ *
+ * @param[in]   enc     Encoder context
+ */
+void nanocbor_encoder_set_canonical(nanocbor_encoder_t *enc);
+
 /**
  * @brief Retrieve the encoded length of the CBOR structure
  *
@@ -852,6 +2400,26 @@ int nanocbor_put_tstr(nanocbor_encoder_t *enc, const char *str);
  */
 int nanocbor_put_tstrn(nanocbor_encoder_t *enc, const char *str, size_t len);
 
+/**
+ * @brief Write an RFC 8746 typed array into the encoder buffer
+ *
+ * The elements are written as a single byte string in host byte order without
+ * per element headers. The byte order flag of @p tag is adjusted to the host
+ * byte order for elements larger than a single byte.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[in]   tag         Typed array tag describing the element type
+ * @param[in]   elements    Elements to encode
+ * @param[in]   num         Number of elements
+ *
+ * @return              NANOCBOR_OK if the typed array fits
+ * @return              NANOCBOR_ERR_INVALID_TYPE if @p tag is not a typed
+ *                      array tag
+ * @return              Negative on error
+ */
+int nanocbor_put_typed_array(nanocbor_encoder_t *enc, uint8_t tag,
+                             const void *elements, size_t num);
+
 /**
  * @brief Write an array indicator with @p len items
  *
@@ -882,6 +2450,106 @@ int nanocbor_fmt_array(nanocbor_encoder_t *enc, size_t len);
  */
 int nanocbor_fmt_map(nanocbor_encoder_t *enc, size_t len);
 
+/**
+ * @brief Start an array with a length that is filled in on close
+ *
+ * Reserves space for the largest header in the memory buffer of @p enc.
+ * Items are encoded as usual and counted by the encoder as they are written,
+ * @ref nanocbor_fmt_container_close writes the shortest definite length
+ * header and moves the items back over the unused header space. This avoids
+ * sizing the array in a separate pass. Containers opened this way can be
+ * nested. When the header does not fit, the container is not opened and only
+ * needs to be closed to report the error.
+ *
+ * @param[in]   enc         Encoder context, initialized with a memory buffer
+ * @param[out]  container   Container context
+ *
+ * @return              Number of bytes reserved
+ * @return              NANOCBOR_ERR_INVALID_TYPE when @p enc does not write
+ *                      to a memory buffer
+ * @return              NANOCBOR_ERR_END when the header does not fit
+ */
+int nanocbor_fmt_array_open(nanocbor_encoder_t *enc,
+                            nanocbor_container_t *container);
+
+/**
+ * @brief Start a map with a length that is filled in on close
+ *
+ * See @ref nanocbor_fmt_array_open, the number of pairs is written on
+ * close.
+ *
+ * @param[in]   enc         Encoder context, initialized with a memory buffer
+ * @param[out]  container   Container context
+ *
+ * @return              Number of bytes reserved
+ * @return              NANOCBOR_ERR_INVALID_TYPE when @p enc does not write
+ *                      to a memory buffer
+ * @return              Negative on other errors
+ */
+int nanocbor_fmt_map_open(nanocbor_encoder_t *enc,
+                          nanocbor_container_t *container);
+
+/**
+ * @brief Close a container opened with @ref nanocbor_fmt_array_open or
+ *        @ref nanocbor_fmt_map_open
+ *
+ * Containers must be closed in reverse order of opening, closing any other
+ * than the innermost open container fails and leaves it open. When the
+ * buffer was too small, @ref nanocbor_encoded_len is an upper bound for the
+ * required size afterwards.
+ *
+ * @param[in]   enc         Encoder context
+ * @param[in]   container   Container context
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END when the header or the items did not
+ *                      fit
+ * @return              NANOCBOR_ERR_INVALID_TYPE when @p container is not the
+ *                      innermost open container, a map has a key without
+ *                      value or the last item is incomplete
+ */
+int nanocbor_fmt_container_close(nanocbor_encoder_t *enc,
+                                 nanocbor_container_t *container);
+
+/**
+ * @brief Start a map that is emitted with its keys sorted
+ *
+ * The keys and values of the map are written to @p map->enc, which stages
+ * them in @p arena. @ref nanocbor_fmt_sorted_map_close emits the map to
+ * @p enc with its entries sorted bytewise by their encoded key, as required
+ * by RFC 8949 section 4.2.1. Nothing is written to @p enc before then, nested
+ * sorted maps use @p map->enc as their parent encoder.
+ *
+ * The arena holds the encoded entries followed by a small index of
+ * `3 * sizeof(size_t)` bytes per entry. The start offsets of the keys and
+ * values are recorded in the index as they are written, closing the map does
+ * not parse the staged entries again. @ref nanocbor_reserve rejects
+ * @p map->enc, the unchecked encoder functions can not account for the index.
+ *
+ * @param[in]   enc     Encoder context to emit the map to
+ * @param[out]  map     Sorted map context
+ * @param[in]   arena   Staging buffer
+ * @param[in]   size    Size of @p arena in bytes
+ */
+void nanocbor_fmt_sorted_map_open(nanocbor_encoder_t *enc,
+                                  nanocbor_sorted_map_t *map, uint8_t *arena,
+                                  size_t size);
+
+/**
+ * @brief Emit a sorted map to its parent encoder
+ *
+ * @param[in]   map     Sorted map context
+ *
+ * @return              NANOCBOR_OK on success
+ * @return              NANOCBOR_ERR_END when the arena or the parent
+ *                      encoder is too small
+ * @return              NANOCBOR_ERR_DUPLICATE_KEY when a key is used twice
+ * @return              NANOCBOR_ERR_INVALID_TYPE when a key has no value or
+ *                      the last item is incomplete
+ * @return              Negative on other errors
+ */
+int nanocbor_fmt_sorted_map_close(nanocbor_sorted_map_t *map);
+
 /**
  * @brief Write an indefinite-length array indicator
  *
@@ -955,6 +2623,98 @@ int nanocbor_fmt_double(nanocbor_encoder_t *enc, double num);
  */
 int nanocbor_fmt_decimal_frac(nanocbor_encoder_t *enc, int32_t e, int32_t m);
 
+/**
+ * @brief Check once that a batch of unchecked writes fits the buffer
+ *
+ * The `_unchecked` functions below do no bounds checks. They may only be
+ * used after a successful reservation that covers all of them, see the
+ * `NANOCBOR_ENCODED_SIZE_*` macros for the size of each item.
+ *
+ * @param[in]   enc     Encoder context, initialized with a memory buffer
+ * @param[in]   len     Maximum number of bytes written by the batch
+ *
+ * @return              NANOCBOR_OK if @p len bytes fit
+ * @return              NANOCBOR_ERR_END if they do not fit
+ * @return              NANOCBOR_ERR_INVALID_TYPE when @p enc does not write
+ *                      to a memory buffer or stages a sorted map
+ */
+int nanocbor_reserve(nanocbor_encoder_t *enc, size_t len);
+
+/**
+ * @brief Write an unsigned integer without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   num     unsigned integer to encode
+ */
+void nanocbor_fmt_uint_unchecked(nanocbor_encoder_t *enc, uint64_t num);
+
+/**
+ * @brief Write a signed integer without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   num     signed integer to encode
+ */
+void nanocbor_fmt_int_unchecked(nanocbor_encoder_t *enc, int64_t num);
+
+/**
+ * @brief Write a tag without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   num     tag number to encode
+ */
+void nanocbor_fmt_tag_unchecked(nanocbor_encoder_t *enc, uint64_t num);
+
+/**
+ * @brief Write an array indicator without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   len     Number of items in the array
+ */
+void nanocbor_fmt_array_unchecked(nanocbor_encoder_t *enc, size_t len);
+
+/**
+ * @brief Write a map indicator without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   len     Number of pairs in the map
+ */
+void nanocbor_fmt_map_unchecked(nanocbor_encoder_t *enc, size_t len);
+
+/**
+ * @brief Write a boolean without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   content Boolean value to write
+ */
+void nanocbor_fmt_bool_unchecked(nanocbor_encoder_t *enc, bool content);
+
+/**
+ * @brief Write a Null value without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ */
+void nanocbor_fmt_null_unchecked(nanocbor_encoder_t *enc);
+
+/**
+ * @brief Copy a byte string without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   str     byte string to encode
+ * @param[in]   len     Length of @p str
+ */
+void nanocbor_put_bstr_unchecked(nanocbor_encoder_t *enc, const uint8_t *str,
+                                 size_t len);
+
+/**
+ * @brief Copy a text string without bounds check
+ *
+ * @param[in]   enc     Encoder context, see @ref nanocbor_reserve
+ * @param[in]   str     text string to encode
+ * @param[in]   len     Length of @p str
+ */
+void nanocbor_put_tstrn_unchecked(nanocbor_encoder_t *enc, const char *str,
+                                  size_t len);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,152 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Deterministically encoded maps with sorted keys
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#include "internal.h"
+
+/* Staged map entry, stored at the end of the arena */
+typedef struct {
+    size_t key; /* Offset of the encoded key in the arena */
+    size_t key_len; /* Length of the encoded key */
+    size_t len; /* Length of the encoded key and value */
+} staged_entry_t;
+
+/* Bytewise lexicographic order of the encoded keys, RFC 8949 4.2.1 */
+static int _key_cmp(const uint8_t *arena, const staged_entry_t *a,
+                    const staged_entry_t *b)
+{
+    size_t min = a->key_len < b->key_len ? a->key_len : b->key_len;
+    int cmp = memcmp(arena + a->key, arena + b->key, min);
+    if (cmp != 0 || a->key_len == b->key_len) {
+        return cmp;
+    }
+    return a->key_len < b->key_len ? -1 : 1;
+}
+
+/* Insertion sort, maps are small and often already close to sorted */
+static int _sort(const uint8_t *arena, staged_entry_t *entries, size_t num)
+{
+    for (size_t i = 1; i < num; i++) {
+        staged_entry_t tmp = entries[i];
+        size_t j = i;
+        int cmp = 1;
+        while (j > 0 && (cmp = _key_cmp(arena, &entries[j - 1], &tmp)) > 0) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        if (j > 0 && cmp == 0) {
+            return NANOCBOR_ERR_DUPLICATE_KEY;
+        }
+        entries[j] = tmp;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _put_encoded(nanocbor_encoder_t *enc, const uint8_t *buf,
+                        size_t len)
+{
+    enc->len += len;
+    if (!enc->fits(enc, enc->context, len)) {
+        return NANOCBOR_ERR_END;
+    }
+    enc->append(enc, enc->context, buf, len);
+    return NANOCBOR_OK;
+}
+
+void nanocbor_fmt_sorted_map_open(nanocbor_encoder_t *enc,
+                                  nanocbor_sorted_map_t *map, uint8_t *arena,
+                                  size_t size)
+{
+    /* The offset index grows down from the aligned end of the arena and is
+     * turned into the entry index on close */
+    uintptr_t top = (uintptr_t)(arena + size);
+    top -= top % sizeof(size_t);
+    size_t staging = top > (uintptr_t)arena ? (size_t)(top - (uintptr_t)arena)
+                                            : 0;
+
+    map->parent = enc;
+    map->arena = arena;
+    map->size = staging;
+    nanocbor_encoder_init(&map->enc, arena, staging);
+    map->enc.flags |= enc->flags & NANOCBOR_ENCODER_FLAG_CANONICAL;
+
+    map->container.start = NULL;
+    map->container.len = 0;
+    map->container.items = 0;
+    map->container.pending = 0;
+    map->container.indefinite = 0;
+    map->container.parent = NULL;
+    map->container.type = NANOCBOR_MASK_MAP;
+    map->container.indexed = true;
+    map->enc.container = &map->container;
+}
+
+int nanocbor_fmt_sorted_map_close(nanocbor_sorted_map_t *map)
+{
+    const nanocbor_container_t *container = &map->container;
+    size_t used = nanocbor_encoded_len(&map->enc);
+
+    /* The staged items or their offsets did not fit */
+    if (used != (size_t)(map->enc.cur - map->arena)) {
+        return NANOCBOR_ERR_END;
+    }
+    /* A key without a value or an incomplete item is a caller error, not a
+     * lack of space */
+    if (container->pending > 0 || container->indefinite > 0
+        || container->items % 2) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+
+    /* Item i starts at *(first - i), the entries overlap the offsets and
+     * are filled from the last one down so no offset is overwritten before
+     * it is read */
+    size_t num = (size_t)(container->items / 2);
+    if ((map->size - used) / sizeof(staged_entry_t) < num) {
+        return NANOCBOR_ERR_END;
+    }
+    const size_t *first = (const size_t *)(map->arena + map->size) - 1;
+    staged_entry_t *entries = (staged_entry_t *)(map->arena + map->size) - num;
+    for (size_t i = num; i-- > 0;) {
+        size_t key = *(first - 2 * i);
+        size_t value = *(first - 2 * i - 1);
+        size_t end = i + 1 < num ? *(first - 2 * i - 2) : used;
+        staged_entry_t *entry = &entries[num - 1 - i];
+        entry->key = key;
+        entry->key_len = value - key;
+        entry->len = end - key;
+    }
+
+    int res = _sort(map->arena, entries, num);
+    if (res < 0) {
+        return res;
+    }
+    /* The entries are complete items, the map is a single item of an
+     * enclosing container */
+    uint8_t header[1 + sizeof(uint64_t)];
+    uint8_t type = NANOCBOR_MASK_MAP;
+    unsigned extrabytes = _arg_size(num, &type);
+    _put_arg(header, num, type, extrabytes);
+    _count_item(map->parent, NANOCBOR_MASK_MAP, 0);
+    res = _put_encoded(map->parent, header, extrabytes + 1);
+    for (size_t i = 0; i < num && res >= 0; i++) {
+        res = _put_encoded(map->parent, map->arena + entries[i].key,
+                           entries[i].len);
+    }
+    return res < 0 ? res : NANOCBOR_OK;
+}
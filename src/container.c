@@ -0,0 +1,184 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Definite length containers with a backpatched header
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#include "internal.h"
+
+/* Largest header, the initial byte followed by a 64 bit argument */
+#define HEADER_MAX (1U + sizeof(uint64_t))
+
+/* Store the start offset of an item below the end of the buffer */
+static void _index_item(nanocbor_encoder_t *enc,
+                        const nanocbor_container_t *container)
+{
+    size_t offset = enc->len - container->len;
+
+    /* Without space for the offset the item does not fit either */
+    if (enc->cur > enc->end
+        || (size_t)(enc->end - enc->cur) < sizeof(offset)) {
+        enc->end = enc->cur;
+        return;
+    }
+    enc->end -= sizeof(offset);
+    memcpy(enc->end, &offset, sizeof(offset));
+}
+
+void nanocbor_container_item(nanocbor_encoder_t *enc, uint8_t ib,
+                             uint64_t num)
+{
+    nanocbor_container_t *container = enc->container;
+    uint8_t type = ib & NANOCBOR_TYPE_MASK;
+    bool indefinite
+        = (ib & NANOCBOR_VALUE_MASK) == NANOCBOR_SIZE_INDEFINITE;
+
+    /* Contents of indefinite length items only matter for their break */
+    if (container->indefinite > 0) {
+        if (indefinite) {
+            if (type == NANOCBOR_MASK_FLOAT) {
+                container->indefinite--;
+            }
+            else {
+                container->indefinite++;
+            }
+        }
+        return;
+    }
+    /* A break marker without indefinite length item is not an item */
+    if (indefinite && type == NANOCBOR_MASK_FLOAT) {
+        return;
+    }
+    if (container->pending > 0) {
+        container->pending--;
+    }
+    else {
+        if (container->indexed) {
+            _index_item(enc, container);
+        }
+        container->items++;
+    }
+    if (indefinite) {
+        container->indefinite++;
+        return;
+    }
+    switch (type) {
+    case NANOCBOR_MASK_ARR:
+        container->pending += num;
+        break;
+    case NANOCBOR_MASK_MAP:
+        container->pending += 2 * num;
+        break;
+    case NANOCBOR_MASK_TAG:
+        container->pending++;
+        break;
+    default:
+        break;
+    }
+}
+
+static int _container_open(nanocbor_encoder_t *enc,
+                           nanocbor_container_t *container, uint8_t type)
+{
+    nanocbor_container_t *parent = enc->container;
+    size_t need = HEADER_MAX;
+
+    container->start = NULL;
+    container->type = type;
+    /* The header is patched in place, only memory buffers allow that */
+    if (!(enc->flags & NANOCBOR_ENCODER_FLAG_MEMORY)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    /* An indexed parent also stores the offset of the container */
+    if (parent && parent->indexed && parent->pending == 0
+        && parent->indefinite == 0) {
+        need += sizeof(size_t);
+    }
+    if (enc->cur > enc->end || (size_t)(enc->end - enc->cur) < need) {
+        enc->len += HEADER_MAX;
+        return NANOCBOR_ERR_END;
+    }
+    /* The container is a single item of the enclosing container, its
+     * contents are counted by the container itself */
+    if (parent) {
+        nanocbor_container_item(enc, type, 0);
+    }
+    container->items = 0;
+    container->pending = 0;
+    container->indefinite = 0;
+    container->indexed = false;
+    container->parent = parent;
+    enc->container = container;
+    enc->len += HEADER_MAX;
+    container->start = enc->cur;
+    enc->cur += HEADER_MAX;
+    container->len = enc->len;
+    return (int)HEADER_MAX;
+}
+
+int nanocbor_fmt_array_open(nanocbor_encoder_t *enc,
+                            nanocbor_container_t *container)
+{
+    return _container_open(enc, container, NANOCBOR_MASK_ARR);
+}
+
+int nanocbor_fmt_map_open(nanocbor_encoder_t *enc,
+                          nanocbor_container_t *container)
+{
+    return _container_open(enc, container, NANOCBOR_MASK_MAP);
+}
+
+int nanocbor_fmt_container_close(nanocbor_encoder_t *enc,
+                                 nanocbor_container_t *container)
+{
+    if (container->start == NULL) {
+        return NANOCBOR_ERR_END;
+    }
+    /* Only the innermost open container can be closed */
+    if (enc->container != container) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    enc->container = container->parent;
+    uint8_t *body = container->start + HEADER_MAX;
+    size_t body_len = (size_t)(enc->cur - body);
+    /* Part of the body did not fit */
+    if (enc->len - container->len != body_len) {
+        return NANOCBOR_ERR_END;
+    }
+    /* The last item is incomplete */
+    if (container->pending > 0 || container->indefinite > 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+
+    uint64_t items = container->items;
+    if (container->type == NANOCBOR_MASK_MAP) {
+        if (items % 2) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        items /= 2;
+    }
+
+    /* Move the body back against the shortest header */
+    uint8_t type = container->type;
+    unsigned extrabytes = _arg_size(items, &type);
+    size_t unused = HEADER_MAX - (extrabytes + 1);
+    _put_arg(container->start, items, type, extrabytes);
+    memmove(body - unused, body, body_len);
+    enc->cur -= unused;
+    enc->len -= unused;
+    return NANOCBOR_OK;
+}
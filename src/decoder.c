@@ -22,6 +22,17 @@
 
 #include NANOCBOR_BYTEORDER_HEADER
 
+#if NANOCBOR_USE_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#elif NANOCBOR_USE_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Mode flags passed on to the containers entered from a decoder */
+#define DECODER_FLAGS_INHERITED                                                \
+    (NANOCBOR_DECODER_FLAG_STREAM | NANOCBOR_DECODER_FLAG_SORTED               \
+     | NANOCBOR_DECODER_FLAG_STRICT_UTF8)
+
 void nanocbor_decoder_init(nanocbor_value_t *value, const uint8_t *buf,
                            size_t len)
 {
@@ -30,6 +41,41 @@ void nanocbor_decoder_init(nanocbor_value_t *value, const uint8_t *buf,
     value->flags = 0;
 }
 
+void nanocbor_decoder_stream_init(nanocbor_value_t *value, const uint8_t *buf,
+                                  size_t len)
+{
+    nanocbor_decoder_init(value, buf, len);
+    value->flags = NANOCBOR_DECODER_FLAG_STREAM;
+}
+
+void nanocbor_decoder_set_sorted(nanocbor_value_t *value)
+{
+    value->flags |= NANOCBOR_DECODER_FLAG_SORTED;
+}
+
+void nanocbor_decoder_set_strict_utf8(nanocbor_value_t *value)
+{
+    value->flags |= NANOCBOR_DECODER_FLAG_STRICT_UTF8;
+}
+
+void nanocbor_decoder_stream_feed(nanocbor_value_t *value, size_t len)
+{
+    value->end += len;
+}
+
+void nanocbor_decoder_stream_sync(nanocbor_value_t *value,
+                                  const nanocbor_value_t *parent)
+{
+    value->end = parent->end;
+    value->flags = (value->flags & (uint8_t)~NANOCBOR_DECODER_FLAG_STREAM)
+        | (parent->flags & NANOCBOR_DECODER_FLAG_STREAM);
+}
+
+void nanocbor_decoder_stream_finish(nanocbor_value_t *value)
+{
+    value->flags &= (uint8_t)~NANOCBOR_DECODER_FLAG_STREAM;
+}
+
 static void _advance(nanocbor_value_t *cvalue, unsigned int res)
 {
     cvalue->cur += res;
@@ -44,11 +90,53 @@ static int _advance_if(nanocbor_value_t *cvalue, int res)
     return res;
 }
 
+/*
+ * Initial byte classification, one table entry per initial byte.
+ *
+ * The lower bits hold the length of the item header in bytes, including the
+ * initial byte, the upper bits flag special cases. Reserved additional
+ * information values (28-30) and indefinite lengths have a header length of
+ * zero as they carry no argument.
+ */
+#define IB_HDR_LEN_MASK (0x0FU) /* Header length including initial byte */
+#define IB_INDEFINITE (0x10U) /* Indefinite length string or container */
+#define IB_BREAK (0x20U) /* Break marker */
+#define IB_SIMPLE (0x40U) /* Simple value */
+
+#define IB_BREAK_BYTE (NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_INDEFINITE)
+
+#define IB_REPEAT4(x) x, x, x, x
+#define IB_REPEAT24(x)                                                         \
+    IB_REPEAT4(x), IB_REPEAT4(x), IB_REPEAT4(x), IB_REPEAT4(x),                \
+        IB_REPEAT4(x), IB_REPEAT4(x)
+/* One major type: immediate values, 1, 2, 4 and 8 byte arguments, reserved
+ * values and the indefinite length entry */
+#define IB_MAJOR(flags, last)                                                  \
+    IB_REPEAT24(1U | (flags)), 2U | (flags), 3U, 5U, 9U, 0U, 0U, 0U, (last)
+
+static const uint8_t _ib_table[256] = {
+    IB_MAJOR(0U, 0U), /* NANOCBOR_TYPE_UINT */
+    IB_MAJOR(0U, 0U), /* NANOCBOR_TYPE_NINT */
+    IB_MAJOR(0U, IB_INDEFINITE), /* NANOCBOR_TYPE_BSTR */
+    IB_MAJOR(0U, IB_INDEFINITE), /* NANOCBOR_TYPE_TSTR */
+    IB_MAJOR(0U, IB_INDEFINITE), /* NANOCBOR_TYPE_ARR */
+    IB_MAJOR(0U, IB_INDEFINITE), /* NANOCBOR_TYPE_MAP */
+    IB_MAJOR(0U, 0U), /* NANOCBOR_TYPE_TAG */
+    IB_MAJOR(IB_SIMPLE, IB_BREAK), /* NANOCBOR_TYPE_FLOAT */
+};
+
 static inline bool _over_end(const nanocbor_value_t *it)
 {
     return it->cur >= it->end;
 }
 
+/* Error for running out of input, more input might follow in a stream */
+static inline int _end_err(const nanocbor_value_t *it)
+{
+    return (it->flags & NANOCBOR_DECODER_FLAG_STREAM) ? NANOCBOR_ERR_NEED_MORE
+                                                      : NANOCBOR_ERR_END;
+}
+
 static inline uint8_t _get_type(const nanocbor_value_t *value)
 {
     return (*value->cur & NANOCBOR_TYPE_MASK);
@@ -59,7 +147,7 @@ static int _value_match_exact(nanocbor_value_t *cvalue, uint8_t val)
     int res = NANOCBOR_ERR_INVALID_TYPE;
 
     if (_over_end(cvalue)) {
-        res = NANOCBOR_ERR_END;
+        res = _end_err(cvalue);
     }
     else if (*cvalue->cur == val) {
         _advance(cvalue, 1U);
@@ -70,21 +158,22 @@ static int _value_match_exact(nanocbor_value_t *cvalue, uint8_t val)
 
 bool nanocbor_at_end(const nanocbor_value_t *it)
 {
-    bool end = false;
-    /* The container is at the end when */
-    if (_over_end(it) || /* Number of items exhausted */
-        /* Indefinite container and the current item is the end marker */
-        ((nanocbor_container_indefinite(it)
-          && *it->cur
-              == (NANOCBOR_TYPE_FLOAT << NANOCBOR_TYPE_OFFSET
-                  | NANOCBOR_VALUE_MASK)))
-        ||
-        /* Or the remaining number of items is zero */
-        (!nanocbor_container_indefinite(it) && nanocbor_in_container(it)
-         && it->remaining == 0)) {
-        end = true;
+    /* The buffer is exhausted, a stream is only at the end when the
+     * container is known to be complete */
+    if (_over_end(it)) {
+        return !(it->flags & NANOCBOR_DECODER_FLAG_STREAM)
+            || (nanocbor_in_container(it) && !nanocbor_container_indefinite(it)
+                && it->remaining == 0);
+    }
+    if (!nanocbor_in_container(it)) {
+        return false;
     }
-    return end;
+    /* Indefinite container and the current item is the end marker */
+    if (nanocbor_container_indefinite(it)) {
+        return _ib_table[*it->cur] & IB_BREAK;
+    }
+    /* Or the remaining number of items is zero */
+    return it->remaining == 0;
 }
 
 int nanocbor_get_type(const nanocbor_value_t *value)
@@ -92,9 +181,51 @@ int nanocbor_get_type(const nanocbor_value_t *value)
     if (nanocbor_at_end(value)) {
         return NANOCBOR_ERR_END;
     }
+    if (_over_end(value)) {
+        return NANOCBOR_ERR_NEED_MORE;
+    }
     return (_get_type(value) >> NANOCBOR_TYPE_OFFSET);
 }
 
+/* Decode the argument of the header at the current position, the caller
+ * checked that the value is not at the end */
+static int _get_arg(const nanocbor_value_t *cvalue, uint64_t *value,
+                    uint8_t max)
+{
+    const uint8_t *cur = cvalue->cur;
+    unsigned hdr_len = _ib_table[*cur] & IB_HDR_LEN_MASK;
+
+    if (hdr_len == 1) {
+        *value = *cur & NANOCBOR_VALUE_MASK;
+        return 1;
+    }
+    if ((*cur & NANOCBOR_VALUE_MASK) > max) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    if ((size_t)(cvalue->end - cur) < hdr_len) {
+        return _end_err(cvalue);
+    }
+    switch (hdr_len) {
+    case 2:
+        *value = cur[1];
+        break;
+    case 3:
+        *value = ((uint16_t)cur[1] << 8U) | cur[2];
+        break;
+    case 5:
+        *value = ((uint32_t)cur[1] << 24U) | ((uint32_t)cur[2] << 16U)
+            | ((uint32_t)cur[3] << 8U) | cur[4];
+        break;
+    default: {
+        uint64_t tmp = 0;
+        memcpy(&tmp, cur + 1, sizeof(tmp));
+        /* NOLINTNEXTLINE: user supplied function */
+        *value = NANOCBOR_BE64TOH_FUNC(tmp);
+    } break;
+    }
+    return (int)hdr_len;
+}
+
 static int _get_uint64(const nanocbor_value_t *cvalue, uint64_t *value,
                        uint8_t max, int type)
 {
@@ -107,32 +238,57 @@ static int _get_uint64(const nanocbor_value_t *cvalue, uint64_t *value,
     if (type != ctype) {
         return NANOCBOR_ERR_INVALID_TYPE;
     }
-    unsigned bytelen = *cvalue->cur & NANOCBOR_VALUE_MASK;
+    return _get_arg(cvalue, value, max);
+}
 
-    if (bytelen < NANOCBOR_SIZE_BYTE) {
-        *value = bytelen;
-        /* Ptr should advance 1 pos */
-        return 1;
+int nanocbor_peek_header(const nanocbor_value_t *value,
+                         nanocbor_header_t *header)
+{
+    if (nanocbor_at_end(value)) {
+        return NANOCBOR_ERR_END;
     }
-    if (bytelen > max) {
-        return NANOCBOR_ERR_OVERFLOW;
+    if (_over_end(value)) {
+        return NANOCBOR_ERR_NEED_MORE;
+    }
+    header->type = _get_type(value) >> NANOCBOR_TYPE_OFFSET;
+    header->value = 0;
+    header->len = 1;
+    header->indefinite = _ib_table[*value->cur] & IB_INDEFINITE;
+    if (header->indefinite) {
+        return NANOCBOR_OK;
     }
 
-    unsigned bytes = 1U << (bytelen - NANOCBOR_SIZE_BYTE);
-
-    if ((cvalue->cur + bytes) >= cvalue->end) {
-        return NANOCBOR_ERR_END;
+    int res = _get_arg(value, &header->value, NANOCBOR_SIZE_LONG);
+    if (res < 0) {
+        /* Reserved values and misplaced break markers */
+        return res == NANOCBOR_ERR_OVERFLOW ? NANOCBOR_ERR_INVALID_TYPE : res;
     }
-    uint64_t tmp = 0;
-    /* Copy the value from cbor to the least significant bytes */
-    memcpy(((uint8_t *)&tmp) + sizeof(uint64_t) - bytes, cvalue->cur + 1U,
-           bytes);
-    /* NOLINTNEXTLINE: user supplied function */
-    tmp = NANOCBOR_BE64TOH_FUNC(tmp);
-    *value = 0;
-    memcpy(value, &tmp, bytes);
+    header->len = (uint8_t)res;
+    return NANOCBOR_OK;
+}
 
-    return (int)(1 + bytes);
+int nanocbor_advance_header(nanocbor_value_t *value,
+                            const nanocbor_header_t *header)
+{
+    if (header->indefinite || header->type == NANOCBOR_TYPE_ARR
+        || header->type == NANOCBOR_TYPE_MAP) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (header->type == NANOCBOR_TYPE_TAG) {
+        value->cur += header->len;
+        return NANOCBOR_OK;
+    }
+    size_t len = header->len;
+    if (header->type == NANOCBOR_TYPE_BSTR
+        || header->type == NANOCBOR_TYPE_TSTR) {
+        if (header->value > (uint64_t)(value->end - value->cur) - len) {
+            return _end_err(value);
+        }
+        len += (size_t)header->value;
+    }
+    value->cur += len;
+    value->remaining--;
+    return NANOCBOR_OK;
 }
 
 static int _get_and_advance_uint8(nanocbor_value_t *cvalue, uint8_t *value,
@@ -205,7 +361,7 @@ static int _get_and_advance_int64(nanocbor_value_t *cvalue, int64_t *value,
     int res = NANOCBOR_ERR_INVALID_TYPE;
     if (type == NANOCBOR_TYPE_NINT || type == NANOCBOR_TYPE_UINT) {
         uint64_t intermediate = 0;
-        res = _get_uint64(cvalue, &intermediate, max, type);
+        res = _get_arg(cvalue, &intermediate, max);
         if (intermediate > bound) {
             res = NANOCBOR_ERR_OVERFLOW;
         }
@@ -273,25 +429,32 @@ int nanocbor_get_tag(nanocbor_value_t *cvalue, uint32_t *tag)
 
 int nanocbor_get_decimal_frac(nanocbor_value_t *cvalue, int32_t *e, int32_t *m)
 {
-    int res = NANOCBOR_NOT_FOUND;
     uint32_t tag = UINT32_MAX;
-    if (nanocbor_get_tag(cvalue, &tag) == NANOCBOR_OK) {
-        if (tag == NANOCBOR_TAG_DEC_FRAC) {
-            nanocbor_value_t arr;
-            if (nanocbor_enter_array(cvalue, &arr) == NANOCBOR_OK) {
-                res = nanocbor_get_int32(&arr, e);
-                if (res >= 0) {
-                    res = nanocbor_get_int32(&arr, m);
-                    if (res >= 0) {
-                        res = NANOCBOR_OK;
-                    }
-                }
-                nanocbor_leave_container(cvalue, &arr);
-            }
-        }
-    }
+    /* Only advance when the whole decimal fraction is decoded */
+    nanocbor_value_t tmp = *cvalue;
+    nanocbor_value_t arr;
 
-    return res;
+    int res = nanocbor_get_tag(&tmp, &tag);
+    if (res < 0) {
+        return res;
+    }
+    if (tag != NANOCBOR_TAG_DEC_FRAC) {
+        return NANOCBOR_NOT_FOUND;
+    }
+    res = nanocbor_enter_array(&tmp, &arr);
+    if (res < 0) {
+        return res;
+    }
+    res = nanocbor_get_int32(&arr, e);
+    if (res >= 0) {
+        res = nanocbor_get_int32(&arr, m);
+    }
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_leave_container(&tmp, &arr);
+    *cvalue = tmp;
+    return NANOCBOR_OK;
 }
 
 static int _get_str(nanocbor_value_t *cvalue, const uint8_t **buf, size_t *len,
@@ -301,12 +464,16 @@ static int _get_str(nanocbor_value_t *cvalue, const uint8_t **buf, size_t *len,
     int res = _get_uint64(cvalue, &tmp, NANOCBOR_SIZE_SIZET, type);
     *len = tmp;
 
-    if (cvalue->end - cvalue->cur < 0
-        || (size_t)(cvalue->end - cvalue->cur) < *len) {
-        return NANOCBOR_ERR_END;
+    if (res >= 0 && (size_t)(cvalue->end - cvalue->cur) - (size_t)res < *len) {
+        return _end_err(cvalue);
     }
     if (res >= 0) {
         *buf = (cvalue->cur) + res;
+        if (type == NANOCBOR_TYPE_TSTR
+            && (cvalue->flags & NANOCBOR_DECODER_FLAG_STRICT_UTF8)
+            && nanocbor_check_utf8(*buf, *len) < 0) {
+            return NANOCBOR_ERR_INVALID_UTF8;
+        }
         _advance(cvalue, (unsigned int)((size_t)res + *len));
         res = NANOCBOR_OK;
     }
@@ -325,6 +492,153 @@ int nanocbor_get_tstr(nanocbor_value_t *cvalue, const uint8_t **buf,
     return _get_str(cvalue, buf, len, NANOCBOR_TYPE_TSTR);
 }
 
+static int _enter_str_chunks(const nanocbor_value_t *it,
+                             nanocbor_value_t *chunks, uint8_t type)
+{
+    int ctype = nanocbor_get_type(it);
+    if (ctype < 0) {
+        return ctype;
+    }
+    if (ctype != type) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    uint8_t inherited = it->flags & DECODER_FLAGS_INHERITED;
+    if (type == NANOCBOR_TYPE_TSTR) {
+        inherited |= NANOCBOR_DECODER_FLAG_TSTR_CHUNKS;
+    }
+    chunks->end = it->end;
+    if (_ib_table[*it->cur] & IB_INDEFINITE) {
+        chunks->flags = NANOCBOR_DECODER_FLAG_INDEFINITE
+            | NANOCBOR_DECODER_FLAG_CONTAINER | inherited;
+        chunks->cur = it->cur + 1;
+        chunks->remaining = 0;
+    }
+    else {
+        /* A definite length string is its own single chunk */
+        chunks->flags = NANOCBOR_DECODER_FLAG_CONTAINER | inherited;
+        chunks->cur = it->cur;
+        chunks->remaining = 1;
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_enter_bstr_chunks(const nanocbor_value_t *it,
+                               nanocbor_value_t *chunks)
+{
+    return _enter_str_chunks(it, chunks, NANOCBOR_TYPE_BSTR);
+}
+
+int nanocbor_enter_tstr_chunks(const nanocbor_value_t *it,
+                               nanocbor_value_t *chunks)
+{
+    return _enter_str_chunks(it, chunks, NANOCBOR_TYPE_TSTR);
+}
+
+int nanocbor_get_next_chunk(nanocbor_value_t *chunks, const uint8_t **buf,
+                            size_t *len)
+{
+    uint8_t type = (chunks->flags & NANOCBOR_DECODER_FLAG_TSTR_CHUNKS)
+        ? NANOCBOR_TYPE_TSTR
+        : NANOCBOR_TYPE_BSTR;
+    return _get_str(chunks, buf, len, type);
+}
+
+static int _get_str_concat(nanocbor_value_t *cvalue, uint8_t *buf, size_t *len,
+                           uint8_t type)
+{
+    nanocbor_value_t tmp = *cvalue;
+    nanocbor_value_t chunks;
+    size_t total = 0;
+
+    int res = _enter_str_chunks(&tmp, &chunks, type);
+    while (res == NANOCBOR_OK && !nanocbor_at_end(&chunks)) {
+        const uint8_t *chunk = NULL;
+        size_t chunk_len = 0;
+        res = nanocbor_get_next_chunk(&chunks, &chunk, &chunk_len);
+        if (res == NANOCBOR_OK && chunk_len > 0) {
+            if (chunk_len > *len - total) {
+                return NANOCBOR_ERR_OVERFLOW;
+            }
+            memcpy(buf + total, chunk, chunk_len);
+            total += chunk_len;
+        }
+    }
+    if (res == NANOCBOR_OK) {
+        nanocbor_leave_container(&tmp, &chunks);
+        *cvalue = tmp;
+        *len = total;
+    }
+    return res;
+}
+
+int nanocbor_get_bstr_concat(nanocbor_value_t *cvalue, uint8_t *buf,
+                             size_t *len)
+{
+    return _get_str_concat(cvalue, buf, len, NANOCBOR_TYPE_BSTR);
+}
+
+int nanocbor_get_tstr_concat(nanocbor_value_t *cvalue, uint8_t *buf,
+                             size_t *len)
+{
+    return _get_str_concat(cvalue, buf, len, NANOCBOR_TYPE_TSTR);
+}
+
+int nanocbor_get_typed_array(nanocbor_value_t *cvalue,
+                             nanocbor_typed_array_t *array)
+{
+    nanocbor_value_t tmp = *cvalue;
+    uint32_t tag = 0;
+    int res = nanocbor_get_tag(&tmp, &tag);
+
+    if (res < 0) {
+        return res;
+    }
+    size_t elem_size = nanocbor_typed_array_elem_size(tag);
+    if (elem_size == 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    res = nanocbor_get_bstr(&tmp, &array->data, &array->len);
+    if (res < 0) {
+        return res;
+    }
+    if (array->len % elem_size) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    array->tag = (uint8_t)tag;
+    array->elem_size = (uint8_t)elem_size;
+    array->num = array->len / elem_size;
+    *cvalue = tmp;
+    return NANOCBOR_OK;
+}
+
+const void *nanocbor_typed_array_elements(const nanocbor_typed_array_t *array,
+                                          void *buf, size_t buf_len)
+{
+    size_t elem_size = array->elem_size;
+    /* NOLINTNEXTLINE: user supplied function */
+    bool host_le = NANOCBOR_HTOBE32_FUNC(1U) != 1U;
+    bool swap = elem_size > 1
+        && host_le != (bool)(array->tag & NANOCBOR_TYPED_ARRAY_LE);
+
+    if (!swap && ((uintptr_t)array->data % elem_size) == 0) {
+        return array->data;
+    }
+    if (buf_len < array->len) {
+        return NULL;
+    }
+    if (!swap) {
+        memcpy(buf, array->data, array->len);
+        return buf;
+    }
+    uint8_t *out = buf;
+    for (size_t i = 0; i < array->len; i += elem_size) {
+        for (size_t j = 0; j < elem_size; j++) {
+            out[i + j] = array->data[i + elem_size - 1 - j];
+        }
+    }
+    return buf;
+}
+
 int nanocbor_get_null(nanocbor_value_t *cvalue)
 {
     return _value_match_exact(cvalue,
@@ -390,85 +704,90 @@ int nanocbor_get_simple(nanocbor_value_t *cvalue, uint8_t *value)
 #define HALF_FLOAT_EXP_POS_DIFF ((uint16_t)(FLOAT_EXP_POS - HALF_EXP_POS))
 #define HALF_EXP_TO_FLOAT (HALF_FLOAT_EXP_DIFF << HALF_EXP_POS)
 
-static int _decode_half_float(nanocbor_value_t *cvalue, float *value)
+static float _half_to_float(uint16_t half)
 {
-    uint64_t tmp = 0;
-    int res
-        = _get_uint64(cvalue, &tmp, NANOCBOR_SIZE_SHORT, NANOCBOR_TYPE_FLOAT);
-    if (res == 1 + sizeof(uint16_t)) {
-        uint32_t *ifloat = (uint32_t *)value;
-        *ifloat = (tmp & HALF_SIGN_MASK) << (FLOAT_SIGN_POS - HALF_SIGN_POS);
+    float value = 0;
+    uint32_t ifloat = (uint32_t)(half & HALF_SIGN_MASK)
+        << (FLOAT_SIGN_POS - HALF_SIGN_POS);
 
-        uint32_t significant = tmp & HALF_FRAC_MASK;
-        uint32_t exponent = tmp & (HALF_EXP_MASK << HALF_EXP_POS);
+    uint32_t significant = half & HALF_FRAC_MASK;
+    uint32_t exponent = half & (HALF_EXP_MASK << HALF_EXP_POS);
 
-        static const uint32_t magic = ((uint32_t)FLOAT_EXP_OFFSET - 1)
-            << FLOAT_EXP_POS;
-        static const float *fmagic = (float *)&magic;
+    static const uint32_t magic = ((uint32_t)FLOAT_EXP_OFFSET - 1)
+        << FLOAT_EXP_POS;
 
-        if (exponent == 0) {
-            *ifloat = magic + significant;
-            *value -= *fmagic;
-        }
-        else {
-            if (exponent == (HALF_EXP_MASK << HALF_EXP_POS)) {
-                /* Set exponent to max value */
-                exponent
-                    = ((FLOAT_EXP_MASK - HALF_FLOAT_EXP_DIFF) << HALF_EXP_POS);
-            }
-            *ifloat
-                |= ((exponent + HALF_EXP_TO_FLOAT) << HALF_FLOAT_EXP_POS_DIFF)
-                | (significant << HALF_FLOAT_EXP_POS_DIFF);
-        }
-        return _advance_if(cvalue, res);
+    if (exponent == 0 && significant == 0) {
+        /* Signed zero */
+        memcpy(&value, &ifloat, sizeof(value));
+        return value;
     }
-    return res > 0 ? NANOCBOR_ERR_INVALID_TYPE : res;
+    if (exponent == 0) {
+        float fmagic = 0;
+        memcpy(&fmagic, &magic, sizeof(fmagic));
+        ifloat |= magic + significant;
+        memcpy(&value, &ifloat, sizeof(value));
+        /* Subtracting the magic number keeps the sign of the result */
+        return ifloat & FLOAT_SIGN_MASK ? value + fmagic : value - fmagic;
+    }
+    if (exponent == (HALF_EXP_MASK << HALF_EXP_POS)) {
+        /* Set exponent to max value */
+        exponent = ((FLOAT_EXP_MASK - HALF_FLOAT_EXP_DIFF) << HALF_EXP_POS);
+    }
+    ifloat |= ((exponent + HALF_EXP_TO_FLOAT) << HALF_FLOAT_EXP_POS_DIFF)
+        | (significant << HALF_FLOAT_EXP_POS_DIFF);
+    memcpy(&value, &ifloat, sizeof(value));
+    return value;
 }
 
-static int _decode_float(nanocbor_value_t *cvalue, float *value)
+/* Decode the header of a floating point value once, the header length
+ * determines the precision of the value */
+static int _get_float_bits(const nanocbor_value_t *cvalue, uint64_t *bits,
+                           uint8_t max)
 {
-    uint64_t tmp = 0;
-    int res
-        = _get_uint64(cvalue, &tmp, NANOCBOR_SIZE_WORD, NANOCBOR_TYPE_FLOAT);
-    if (res == 1 + sizeof(uint32_t)) {
-        uint32_t ifloat = tmp;
-        memcpy(value, &ifloat, sizeof(uint32_t));
-        return _advance_if(cvalue, res);
+    int res = _get_uint64(cvalue, bits, max, NANOCBOR_TYPE_FLOAT);
+    /* Simple values are not floating point values */
+    if (res > 0 && res < (int)(1 + sizeof(uint16_t))) {
+        return NANOCBOR_ERR_INVALID_TYPE;
     }
-    return res > 0 ? NANOCBOR_ERR_INVALID_TYPE : res;
+    return res;
 }
 
-static int _decode_double(nanocbor_value_t *cvalue, double *value)
+static float _word_to_float(uint32_t word)
 {
-    uint64_t tmp = 0;
-    int res
-        = _get_uint64(cvalue, &tmp, NANOCBOR_SIZE_LONG, NANOCBOR_TYPE_FLOAT);
-    if (res == 1 + sizeof(uint64_t)) {
-        uint64_t ifloat = tmp;
-        memcpy(value, &ifloat, sizeof(uint64_t));
-        return _advance_if(cvalue, res);
-    }
-    return res > 0 ? NANOCBOR_ERR_INVALID_TYPE : res;
+    float value = 0;
+    memcpy(&value, &word, sizeof(value));
+    return value;
 }
 
 int nanocbor_get_float(nanocbor_value_t *cvalue, float *value)
 {
-    int res = _decode_half_float(cvalue, value);
-    if (res < 0) {
-        res = _decode_float(cvalue, value);
+    uint64_t tmp = 0;
+    int res = _get_float_bits(cvalue, &tmp, NANOCBOR_SIZE_WORD);
+
+    if (res == 1 + sizeof(uint16_t)) {
+        *value = _half_to_float((uint16_t)tmp);
     }
-    return res;
+    else if (res == 1 + sizeof(uint32_t)) {
+        *value = _word_to_float((uint32_t)tmp);
+    }
+    return _advance_if(cvalue, res);
 }
 
 int nanocbor_get_double(nanocbor_value_t *cvalue, double *value)
 {
-    float tmp = 0;
-    int res = nanocbor_get_float(cvalue, &tmp);
-    if (res >= NANOCBOR_OK) {
-        *value = tmp;
-        return res;
+    uint64_t tmp = 0;
+    int res = _get_float_bits(cvalue, &tmp, NANOCBOR_SIZE_LONG);
+
+    if (res == 1 + sizeof(uint16_t)) {
+        *value = _half_to_float((uint16_t)tmp);
+    }
+    else if (res == 1 + sizeof(uint32_t)) {
+        *value = _word_to_float((uint32_t)tmp);
     }
-    return _decode_double(cvalue, value);
+    else if (res == 1 + sizeof(uint64_t)) {
+        memcpy(value, &tmp, sizeof(uint64_t));
+    }
+    return _advance_if(cvalue, res);
 }
 
 static int _enter_container(const nanocbor_value_t *it,
@@ -476,6 +795,7 @@ static int _enter_container(const nanocbor_value_t *it,
 {
     container->end = it->end;
     container->remaining = 0;
+    uint8_t inherited = it->flags & DECODER_FLAGS_INHERITED;
 
     uint8_t value_match = (uint8_t)(((unsigned)type << NANOCBOR_TYPE_OFFSET)
                                     | NANOCBOR_SIZE_INDEFINITE);
@@ -483,7 +803,7 @@ static int _enter_container(const nanocbor_value_t *it,
     /* Not using _value_match_exact here to keep *it const */
     if (!_over_end(it) && *it->cur == value_match) {
         container->flags = NANOCBOR_DECODER_FLAG_INDEFINITE
-            | NANOCBOR_DECODER_FLAG_CONTAINER;
+            | NANOCBOR_DECODER_FLAG_CONTAINER | inherited;
         container->cur = it->cur + 1;
         return NANOCBOR_OK;
     }
@@ -492,7 +812,7 @@ static int _enter_container(const nanocbor_value_t *it,
     if (res < 0) {
         return res;
     }
-    container->flags = NANOCBOR_DECODER_FLAG_CONTAINER;
+    container->flags = NANOCBOR_DECODER_FLAG_CONTAINER | inherited;
     container->cur = it->cur + res;
     return NANOCBOR_OK;
 }
@@ -518,6 +838,10 @@ void nanocbor_leave_container(nanocbor_value_t *it, nanocbor_value_t *container)
     if (it->remaining) {
         it->remaining--;
     }
+    /* Input fed to the container while decoding it also belongs to the parent */
+    it->end = container->end;
+    it->flags = (it->flags & (uint8_t)~NANOCBOR_DECODER_FLAG_STREAM)
+        | (container->flags & NANOCBOR_DECODER_FLAG_STREAM);
     if (nanocbor_container_indefinite(container)) {
         it->cur = container->cur + 1;
     }
@@ -526,6 +850,157 @@ void nanocbor_leave_container(nanocbor_value_t *it, nanocbor_value_t *container)
     }
 }
 
+/* Number of leading bytes that are unsigned integers with an immediate value */
+static size_t _scan_immediate(const uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+#if NANOCBOR_USE_SIMD && defined(__AVX2__)
+    const __m256i max = _mm256_set1_epi8(NANOCBOR_SIZE_BYTE - 1);
+    for (; i + sizeof(__m256i) <= len; i += sizeof(__m256i)) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(buf + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, max), chunk));
+        if (mask != UINT32_MAX) {
+            return i + (size_t)__builtin_ctz(~mask);
+        }
+    }
+#elif NANOCBOR_USE_SIMD && defined(__SSE2__)
+    const __m128i max = _mm_set1_epi8(NANOCBOR_SIZE_BYTE - 1);
+    for (; i + sizeof(__m128i) <= len; i += sizeof(__m128i)) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_min_epu8(chunk, max), chunk));
+        if (mask != UINT16_MAX) {
+            return i + (size_t)__builtin_ctz(~mask);
+        }
+    }
+#endif
+    while (i < len && buf[i] < NANOCBOR_SIZE_BYTE) {
+        i++;
+    }
+    return i;
+}
+
+/* Length of the run of immediate unsigned integers at the current position of
+ * an array, limited to @p max items */
+static size_t _array_immediate_run(const nanocbor_value_t *arr, size_t max)
+{
+    size_t len = (size_t)(arr->end - arr->cur);
+
+    if (len > max) {
+        len = max;
+    }
+    if (!nanocbor_container_indefinite(arr) && arr->remaining < len) {
+        len = (size_t)arr->remaining;
+    }
+    return _scan_immediate(arr->cur, len);
+}
+
+static void _array_consume(nanocbor_value_t *arr, size_t items, size_t *num)
+{
+    arr->cur += items;
+    arr->remaining -= items;
+    *num += items;
+}
+
+int nanocbor_get_uint32_array(nanocbor_value_t *cvalue, uint32_t *values,
+                              size_t max, size_t *num)
+{
+    nanocbor_value_t arr;
+
+    *num = 0;
+    int res = nanocbor_enter_array(cvalue, &arr);
+    while (res >= 0 && !nanocbor_at_end(&arr)) {
+        if (*num == max) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        size_t run = _array_immediate_run(&arr, max - *num);
+        if (run) {
+            for (size_t i = 0; i < run; i++) {
+                values[*num + i] = arr.cur[i];
+            }
+            _array_consume(&arr, run, num);
+            continue;
+        }
+        res = nanocbor_get_uint32(&arr, &values[*num]);
+        if (res >= 0) {
+            (*num)++;
+        }
+    }
+    if (res >= 0) {
+        nanocbor_leave_container(cvalue, &arr);
+        res = NANOCBOR_OK;
+    }
+    return res;
+}
+
+int nanocbor_get_int64_array(nanocbor_value_t *cvalue, int64_t *values,
+                             size_t max, size_t *num)
+{
+    nanocbor_value_t arr;
+
+    *num = 0;
+    int res = nanocbor_enter_array(cvalue, &arr);
+    while (res >= 0 && !nanocbor_at_end(&arr)) {
+        if (*num == max) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        size_t run = _array_immediate_run(&arr, max - *num);
+        if (run) {
+            for (size_t i = 0; i < run; i++) {
+                values[*num + i] = arr.cur[i];
+            }
+            _array_consume(&arr, run, num);
+            continue;
+        }
+        res = nanocbor_get_int64(&arr, &values[*num]);
+        if (res >= 0) {
+            (*num)++;
+        }
+    }
+    if (res >= 0) {
+        nanocbor_leave_container(cvalue, &arr);
+        res = NANOCBOR_OK;
+    }
+    return res;
+}
+
+int nanocbor_get_float_array(nanocbor_value_t *cvalue, float *values,
+                             size_t max, size_t *num)
+{
+    static const uint8_t single = NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_WORD;
+    nanocbor_value_t arr;
+
+    *num = 0;
+    int res = nanocbor_enter_array(cvalue, &arr);
+    while (res >= 0 && !nanocbor_at_end(&arr)) {
+        if (*num == max) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        /* Single precision values are copied without the generic getter */
+        if (*arr.cur == single
+            && (size_t)(arr.end - arr.cur) >= 1 + sizeof(uint32_t)) {
+            const uint8_t *cur = arr.cur;
+            uint32_t word = ((uint32_t)cur[1] << 24U)
+                | ((uint32_t)cur[2] << 16U) | ((uint32_t)cur[3] << 8U)
+                | cur[4];
+            values[*num] = _word_to_float(word);
+            _advance(&arr, 1 + sizeof(uint32_t));
+            (*num)++;
+            continue;
+        }
+        res = nanocbor_get_float(&arr, &values[*num]);
+        if (res >= 0) {
+            (*num)++;
+        }
+    }
+    if (res >= 0) {
+        nanocbor_leave_container(cvalue, &arr);
+        res = NANOCBOR_OK;
+    }
+    return res;
+}
+
 static int _skip_simple(nanocbor_value_t *it)
 {
     int type = nanocbor_get_type(it);
@@ -554,43 +1029,470 @@ int nanocbor_skip_simple(nanocbor_value_t *it)
     return _skip_simple(it);
 }
 
-/* NOLINTNEXTLINE(misc-no-recursion): Recursion is limited by design */
-static int _skip_limited(nanocbor_value_t *it, uint8_t limit)
+/* Skip the header of the next item, entering it when it is a container */
+static int _skip_item(nanocbor_value_t *walker, nanocbor_stack_entry_t *stack,
+                      size_t *level, size_t depth)
 {
-    if (limit == 0) {
-        return NANOCBOR_ERR_RECURSION;
-    }
-    int type = nanocbor_get_type(it);
-    int res = type;
+    int type = nanocbor_get_type(walker);
 
-    /* map or array */
+    /* Tags are followed by their content, both form a single item */
+    while (type == NANOCBOR_TYPE_TAG) {
+        uint64_t tmp = 0;
+        int res = _get_uint64(walker, &tmp, NANOCBOR_SIZE_LONG, type);
+        if (res < 0) {
+            return res;
+        }
+        walker->cur += res;
+        type = nanocbor_get_type(walker);
+    }
+    if (type < 0) {
+        return type;
+    }
+    if (*level > 0
+        && !(stack[*level - 1].flags & NANOCBOR_DECODER_FLAG_INDEFINITE)) {
+        stack[*level - 1].remaining--;
+    }
+    if ((type == NANOCBOR_TYPE_BSTR || type == NANOCBOR_TYPE_TSTR)
+        && (_ib_table[*walker->cur] & IB_INDEFINITE)) {
+        /* The chunks of an indefinite length string are skipped as children */
+        if (*level == depth) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        stack[*level].remaining = 0;
+        stack[*level].flags = NANOCBOR_DECODER_FLAG_INDEFINITE
+            | NANOCBOR_DECODER_FLAG_CONTAINER;
+        (*level)++;
+        walker->cur++;
+        return NANOCBOR_OK;
+    }
     if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP) {
-        nanocbor_value_t recurse;
-        res = (type == NANOCBOR_TYPE_MAP ? nanocbor_enter_map(it, &recurse)
-                                         : nanocbor_enter_array(it, &recurse));
-        if (res == NANOCBOR_OK) {
-            while (!nanocbor_at_end(&recurse)) {
-                res = _skip_limited(&recurse, limit - 1);
-                if (res < 0) {
+        if (*level == depth) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        nanocbor_value_t container;
+        int res = (type == NANOCBOR_TYPE_MAP
+                       ? nanocbor_enter_map(walker, &container)
+                       : nanocbor_enter_array(walker, &container));
+        if (res < 0) {
+            return res;
+        }
+        stack[*level].remaining = container.remaining;
+        stack[*level].flags = container.flags;
+        (*level)++;
+        walker->cur = container.cur;
+        return NANOCBOR_OK;
+    }
+    return _skip_simple(walker);
+}
+
+/* Leave all containers that are exhausted */
+static void _skip_leave(nanocbor_value_t *walker, nanocbor_stack_entry_t *stack,
+                        size_t *level)
+{
+    while (*level > 0) {
+        const nanocbor_stack_entry_t *top = &stack[*level - 1];
+        if (top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+            if (_over_end(walker) || !(_ib_table[*walker->cur] & IB_BREAK)) {
+                break;
+            }
+            walker->cur++;
+        }
+        else if (top->remaining > 0) {
+            break;
+        }
+        (*level)--;
+    }
+}
+
+int nanocbor_skip_stack(nanocbor_value_t *it, nanocbor_stack_entry_t *stack,
+                        size_t depth)
+{
+    if (nanocbor_at_end(it)) {
+        return NANOCBOR_ERR_END;
+    }
+
+    nanocbor_value_t walker;
+    size_t level = 0;
+
+    nanocbor_decoder_init(&walker, it->cur, (size_t)(it->end - it->cur));
+    walker.flags = it->flags & NANOCBOR_DECODER_FLAG_STREAM;
+    do {
+        int res = _skip_item(&walker, stack, &level, depth);
+        if (res < 0) {
+            return res;
+        }
+        _skip_leave(&walker, stack, &level);
+    } while (level > 0);
+
+    it->cur = walker.cur;
+    it->remaining--;
+    return NANOCBOR_OK;
+}
+
+int nanocbor_skip(nanocbor_value_t *it)
+{
+    nanocbor_stack_entry_t stack[NANOCBOR_RECURSION_MAX];
+
+    return nanocbor_skip_stack(it, stack, NANOCBOR_RECURSION_MAX);
+}
+
+/* Validator stack entry flags for indefinite length strings */
+#define VALIDATE_FLAG_TSTR (0x40U)
+#define VALIDATE_FLAG_CHUNKS (0x80U)
+/* Validator stack entry flag for indefinite length maps, the remaining field
+ * counts the items to track key/value parity */
+#define VALIDATE_FLAG_MAP (0x20U)
+
+/* Close all exhausted containers at the current position */
+static int _validate_leave(nanocbor_value_t *it, nanocbor_stack_entry_t *stack,
+                           size_t *level)
+{
+    while (*level > 0) {
+        const nanocbor_stack_entry_t *top = &stack[*level - 1];
+        if (top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+            if (_over_end(it) || *it->cur != IB_BREAK_BYTE) {
+                return NANOCBOR_OK;
+            }
+            /* A break marker directly after a map key */
+            if ((top->flags & VALIDATE_FLAG_MAP) && (top->remaining & 1U)) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            it->cur++;
+        }
+        else if (top->remaining > 0) {
+            return NANOCBOR_OK;
+        }
+        (*level)--;
+    }
+    return NANOCBOR_OK;
+}
+
+static int _validate_item(nanocbor_value_t *it, nanocbor_stack_entry_t *stack,
+                          size_t *level, size_t depth, uint8_t flags)
+{
+    uint8_t ib = *it->cur;
+    uint8_t info = _ib_table[ib];
+    uint8_t type = ib >> NANOCBOR_TYPE_OFFSET;
+    nanocbor_stack_entry_t *top = *level > 0 ? &stack[*level - 1] : NULL;
+
+    /* Chunks of indefinite length strings are definite length strings of
+     * the same major type */
+    if (top && (top->flags & VALIDATE_FLAG_CHUNKS)
+        && (type
+                != ((top->flags & VALIDATE_FLAG_TSTR) ? NANOCBOR_TYPE_TSTR
+                                                      : NANOCBOR_TYPE_BSTR)
+            || (info & IB_INDEFINITE))) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (info & IB_INDEFINITE) {
+        if (*level == depth) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        stack[*level].remaining = 0;
+        stack[*level].flags = NANOCBOR_DECODER_FLAG_INDEFINITE;
+        if (type == NANOCBOR_TYPE_BSTR) {
+            stack[*level].flags |= VALIDATE_FLAG_CHUNKS;
+        }
+        else if (type == NANOCBOR_TYPE_TSTR) {
+            stack[*level].flags |= VALIDATE_FLAG_CHUNKS | VALIDATE_FLAG_TSTR;
+        }
+        else if (type == NANOCBOR_TYPE_MAP) {
+            stack[*level].flags |= VALIDATE_FLAG_MAP;
+        }
+        (*level)++;
+        it->cur++;
+        return NANOCBOR_OK;
+    }
+    /* Reserved additional information, misplaced indefinite lengths and
+     * break markers */
+    if ((info & IB_HDR_LEN_MASK) == 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+
+    uint64_t arg = 0;
+    int res = _get_arg(it, &arg, NANOCBOR_SIZE_LONG);
+    if (res < 0) {
+        return res;
+    }
+    size_t avail = (size_t)(it->end - it->cur) - (size_t)res;
+    it->cur += res;
+
+    switch (type) {
+    case NANOCBOR_TYPE_BSTR:
+    case NANOCBOR_TYPE_TSTR:
+        if (arg > avail) {
+            return NANOCBOR_ERR_END;
+        }
+        if (type == NANOCBOR_TYPE_TSTR && (flags & NANOCBOR_VALIDATE_FLAG_UTF8)
+            && nanocbor_check_utf8(it->cur, (size_t)arg) < 0) {
+            return NANOCBOR_ERR_INVALID_UTF8;
+        }
+        it->cur += arg;
+        break;
+    case NANOCBOR_TYPE_MAP:
+    case NANOCBOR_TYPE_ARR:
+        /* Every item requires at least a single byte */
+        if (arg > avail) {
+            return NANOCBOR_ERR_END;
+        }
+        if (arg > 0) {
+            if (*level == depth) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            stack[*level].remaining
+                = type == NANOCBOR_TYPE_MAP ? arg * 2 : arg;
+            stack[*level].flags = 0;
+            (*level)++;
+        }
+        break;
+    case NANOCBOR_TYPE_FLOAT:
+        /* Simple values below 32 must use the single byte encoding */
+        if (res == 2 && arg < 32U) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        break;
+    default:
+        break;
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_validate_stack(const uint8_t *buf, size_t len, uint8_t flags,
+                            size_t *offset, nanocbor_stack_entry_t *stack,
+                            size_t depth)
+{
+    nanocbor_value_t it;
+    size_t level = 0;
+    bool tagged = false;
+    int res = NANOCBOR_OK;
+
+    nanocbor_decoder_init(&it, buf, len);
+    while (true) {
+        /* A tag is always followed by its content */
+        if (!tagged) {
+            res = _validate_leave(&it, stack, &level);
+            if (res < 0) {
+                break;
+            }
+            if (level == 0 && _over_end(&it)) {
+                break;
+            }
+        }
+        if (_over_end(&it)) {
+            res = NANOCBOR_ERR_END;
+            break;
+        }
+        const uint8_t *start = it.cur;
+        tagged = (*start & NANOCBOR_TYPE_MASK) == NANOCBOR_MASK_TAG;
+        if (level > 0 && !tagged) {
+            nanocbor_stack_entry_t *top = &stack[level - 1];
+            if (!(top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE)) {
+                top->remaining--;
+            }
+            else if (top->flags & VALIDATE_FLAG_MAP) {
+                top->remaining++;
+            }
+        }
+        res = _validate_item(&it, stack, &level, depth, flags);
+        if (res < 0) {
+            it.cur = start;
+            break;
+        }
+    }
+    if (offset) {
+        *offset = (size_t)(it.cur - buf);
+    }
+    return res;
+}
+
+int nanocbor_validate(const uint8_t *buf, size_t len, uint8_t flags,
+                      size_t *offset)
+{
+    nanocbor_stack_entry_t stack[NANOCBOR_RECURSION_MAX];
+
+    return nanocbor_validate_stack(buf, len, flags, offset, stack,
+                                   NANOCBOR_RECURSION_MAX);
+}
+
+/* Floating point format parameters for the shortest encoding check */
+typedef struct {
+    unsigned mant_bits; /* Number of explicit mantissa bits */
+    int emin; /* Exponent of the smallest normal value */
+    int emax; /* Exponent of the largest normal value */
+} float_format_t;
+
+static const float_format_t _half_format = { 10, -14, 15 };
+static const float_format_t _single_format = { 23, -126, 127 };
+static const float_format_t _double_format = { 52, -1022, 1023 };
+
+/* Whether a value in format @p from is exactly representable in format @p to */
+static bool _float_fits(uint64_t bits, const float_format_t *from,
+                        const float_format_t *to)
+{
+    uint64_t mant = bits & ((1ULL << from->mant_bits) - 1);
+    unsigned exp_bits = (unsigned)(from->emax * 2 + 1);
+    unsigned exp = (unsigned)(bits >> from->mant_bits) & exp_bits;
+    unsigned drop = from->mant_bits - to->mant_bits;
+    int e = (int)exp - from->emax;
+
+    if (exp == exp_bits) {
+        /* Infinity or NaN, the NaN payload must survive */
+        return (mant & ((1ULL << drop) - 1)) == 0;
+    }
+    if (exp == 0) {
+        /* Subnormals of the larger format are always too small */
+        return mant == 0;
+    }
+    if (e > to->emax || e < to->emin - (int)to->mant_bits) {
+        return false;
+    }
+    if (e < to->emin) {
+        /* Subnormal in the smaller format */
+        drop += (unsigned)(to->emin - e);
+        mant |= 1ULL << from->mant_bits;
+    }
+    return (mant & ((1ULL << drop) - 1)) == 0;
+}
+
+/* Bytewise lexicographic order of the encoded map keys, RFC 8949 4.2.1 */
+static bool _key_sorted(const nanocbor_det_entry_t *entry, const uint8_t *end)
+{
+    size_t len = (size_t)(end - entry->key);
+    if (entry->prev == NULL) {
+        return true;
+    }
+    size_t min = len < entry->prev_len ? len : entry->prev_len;
+    int cmp = memcmp(entry->prev, entry->key, min);
+    return cmp < 0 || (cmp == 0 && entry->prev_len < len);
+}
+
+static int _check_det_item(nanocbor_value_t *it, nanocbor_det_entry_t *stack,
+                           size_t *level, size_t depth)
+{
+    uint8_t info = _ib_table[*it->cur];
+    uint8_t type = *it->cur >> NANOCBOR_TYPE_OFFSET;
+
+    if (info & IB_INDEFINITE) {
+        return NANOCBOR_ERR_NOT_DETERMINISTIC;
+    }
+    if ((info & IB_HDR_LEN_MASK) == 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    uint64_t arg = 0;
+    int res = _get_arg(it, &arg, NANOCBOR_SIZE_LONG);
+    if (res < 0) {
+        return res;
+    }
+    size_t avail = (size_t)(it->end - it->cur) - (size_t)res;
+
+    if (type == NANOCBOR_TYPE_FLOAT) {
+        if (res == 2 && arg < 32U) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        if ((res == 5 && _float_fits(arg, &_single_format, &_half_format))
+            || (res == 9
+                && _float_fits(arg, &_double_format, &_single_format))) {
+            return NANOCBOR_ERR_NOT_DETERMINISTIC;
+        }
+    }
+    /* The argument must use the shortest header */
+    else if ((res == 2 && arg < NANOCBOR_SIZE_BYTE)
+             || (res == 3 && arg <= UINT8_MAX)
+             || (res == 5 && arg <= UINT16_MAX)
+             || (res == 9 && arg <= UINT32_MAX)) {
+        return NANOCBOR_ERR_NOT_DETERMINISTIC;
+    }
+    it->cur += res;
+
+    if (type == NANOCBOR_TYPE_BSTR || type == NANOCBOR_TYPE_TSTR) {
+        if (arg > avail) {
+            return NANOCBOR_ERR_END;
+        }
+        it->cur += arg;
+    }
+    else if ((type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP)
+             && arg > 0) {
+        if (arg > avail) {
+            return NANOCBOR_ERR_END;
+        }
+        if (*level == depth) {
+            return NANOCBOR_ERR_RECURSION;
+        }
+        nanocbor_det_entry_t *entry = &stack[(*level)++];
+        entry->map = type == NANOCBOR_TYPE_MAP;
+        entry->remaining = entry->map ? arg * 2 : arg;
+        entry->prev = NULL;
+        entry->prev_len = 0;
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_check_deterministic_stack(const uint8_t *buf, size_t len,
+                                       size_t *offset,
+                                       nanocbor_det_entry_t *stack,
+                                       size_t depth)
+{
+    nanocbor_value_t it;
+    size_t level = 0;
+    bool tagged = false;
+    int res = NANOCBOR_OK;
+
+    nanocbor_decoder_init(&it, buf, len);
+    while (true) {
+        /* A tag and its content form a single item */
+        if (!tagged) {
+            while (level > 0 && stack[level - 1].remaining == 0) {
+                level--;
+            }
+            if (level == 0 && _over_end(&it)) {
+                break;
+            }
+        }
+        if (_over_end(&it)) {
+            res = NANOCBOR_ERR_END;
+            break;
+        }
+        const uint8_t *start = it.cur;
+        nanocbor_det_entry_t *top = level > 0 ? &stack[level - 1] : NULL;
+        if (top && !tagged) {
+            if (top->map && (top->remaining % 2) == 0) {
+                top->key = start;
+            }
+            else if (top->map) {
+                if (!_key_sorted(top, start)) {
+                    it.cur = top->key;
+                    res = NANOCBOR_ERR_NOT_DETERMINISTIC;
                     break;
                 }
+                top->prev = top->key;
+                top->prev_len = (size_t)(start - top->key);
             }
-            nanocbor_leave_container(it, &recurse);
+            top->remaining--;
+        }
+        tagged = (*start & NANOCBOR_TYPE_MASK) == NANOCBOR_MASK_TAG;
+        res = _check_det_item(&it, stack, &level, depth);
+        if (res < 0) {
+            it.cur = start;
+            break;
         }
     }
-    else if (type >= 0) {
-        res = _skip_simple(it);
+    if (offset) {
+        *offset = (size_t)(it.cur - buf);
     }
-    return res < 0 ? res : NANOCBOR_OK;
+    return res;
 }
 
-int nanocbor_skip(nanocbor_value_t *it)
+int nanocbor_check_deterministic(const uint8_t *buf, size_t len,
+                                 size_t *offset)
 {
-    return _skip_limited(it, NANOCBOR_RECURSION_MAX);
+    nanocbor_det_entry_t stack[NANOCBOR_RECURSION_MAX];
+
+    return nanocbor_check_deterministic_stack(buf, len, offset, stack,
+                                              NANOCBOR_RECURSION_MAX);
 }
 
-int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
-                          nanocbor_value_t *value)
+static int _get_key_tstr(nanocbor_index_t *index, nanocbor_value_t *start,
+                         const char *key, nanocbor_value_t *value)
 {
     int res = NANOCBOR_NOT_FOUND;
     size_t len = strlen(key);
@@ -610,11 +1512,352 @@ int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
             break;
         }
 
-        res = nanocbor_skip(value);
+        res = index ? nanocbor_index_skip(index, value) : nanocbor_skip(value);
         if (res < 0) {
             break;
         }
+        res = NANOCBOR_NOT_FOUND;
     }
 
     return res;
 }
+
+int nanocbor_get_key_tstr(nanocbor_value_t *start, const char *key,
+                          nanocbor_value_t *value)
+{
+    return _get_key_tstr(NULL, start, key, value);
+}
+
+static int _get_key_int(nanocbor_value_t *start, uint8_t type, uint64_t arg,
+                        nanocbor_value_t *value)
+{
+    bool sorted = start->flags & NANOCBOR_DECODER_FLAG_SORTED;
+    *value = *start;
+
+    while (!nanocbor_at_end(value)) {
+        nanocbor_header_t header;
+        int res = nanocbor_peek_header(value, &header);
+        if (res < 0) {
+            return res;
+        }
+        if (header.type == type && header.value == arg && !header.indefinite) {
+            return nanocbor_advance_header(value, &header);
+        }
+        /* Deterministically encoded keys are sorted bytewise, for integer
+         * keys in preferred encoding this is by major type and then by
+         * argument */
+        if (sorted
+            && (header.type > type
+                || (header.type == type && header.value > arg))) {
+            break;
+        }
+        res = nanocbor_skip(value);
+        if (res >= 0) {
+            res = nanocbor_skip(value);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_NOT_FOUND;
+}
+
+int nanocbor_get_key_uint(nanocbor_value_t *start, uint64_t key,
+                          nanocbor_value_t *value)
+{
+    return _get_key_int(start, NANOCBOR_TYPE_UINT, key, value);
+}
+
+int nanocbor_get_key_int(nanocbor_value_t *start, int64_t key,
+                         nanocbor_value_t *value)
+{
+    if (key < 0) {
+        return _get_key_int(start, NANOCBOR_TYPE_NINT, (uint64_t)(-(key + 1)),
+                            value);
+    }
+    return _get_key_int(start, NANOCBOR_TYPE_UINT, (uint64_t)key, value);
+}
+
+/* Match a map key against all requested keys that are not found yet */
+static size_t _match_keys(const uint8_t *s, size_t s_len,
+                          const char *const keys[], size_t n,
+                          const nanocbor_value_t *value, nanocbor_value_t out[])
+{
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        /* While searching, remaining holds the length of the key */
+        if (out[i].cur == NULL && out[i].remaining == s_len
+            && (s_len == 0 || (s[0] == (uint8_t)keys[i][0]
+                               && !memcmp(s, keys[i], s_len)))) {
+            out[i] = *value;
+            found++;
+        }
+    }
+    return found;
+}
+
+int nanocbor_get_keys_tstr(const nanocbor_value_t *start,
+                           const char *const keys[], size_t n,
+                           nanocbor_value_t out[])
+{
+    nanocbor_value_t it = *start;
+    /* Bit per key length modulo 64, rejects most keys without comparing */
+    uint64_t lengths = 0;
+    size_t found = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        nanocbor_decoder_init(&out[i], NULL, 0);
+        out[i].remaining = strlen(keys[i]);
+        lengths |= 1ULL << (out[i].remaining % 64U);
+    }
+
+    while (found < n && !nanocbor_at_end(&it)) {
+        const uint8_t *s = NULL;
+        size_t s_len = 0;
+        int res = nanocbor_get_type(&it);
+        if (res == NANOCBOR_TYPE_TSTR) {
+            res = nanocbor_get_tstr(&it, &s, &s_len);
+            if (res == NANOCBOR_OK && (lengths & (1ULL << (s_len % 64U)))) {
+                found += _match_keys(s, s_len, keys, n, &it, out);
+            }
+        }
+        else if (res >= 0) {
+            /* Keys of other types never match */
+            res = nanocbor_skip(&it);
+        }
+        if (res >= 0) {
+            res = nanocbor_skip(&it);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (out[i].cur == NULL) {
+            out[i].remaining = 0;
+        }
+    }
+    return (int)found;
+}
+
+/* No entry, used to terminate the chain of open containers */
+#define INDEX_NONE SIZE_MAX
+
+void nanocbor_index_init(nanocbor_index_t *index,
+                         nanocbor_index_entry_t *entries, size_t num_entries)
+{
+    index->buf = NULL;
+    index->len = 0;
+    index->entries = entries;
+    index->capacity = num_entries;
+    index->num = 0;
+    index->hint = 0;
+}
+
+/* Number of child items of a container, tag or indefinite string */
+static int _index_children(nanocbor_index_entry_t *entry,
+                           const nanocbor_value_t *it, size_t *count)
+{
+    if (entry->flags & NANOCBOR_INDEX_FLAG_INDEFINITE) {
+        *count = 0;
+        return NANOCBOR_OK;
+    }
+    if (entry->type == NANOCBOR_TYPE_TAG) {
+        *count = 1;
+        return NANOCBOR_OK;
+    }
+    /* Every child requires at least a single byte */
+    if (entry->argument > (uint64_t)(it->end - it->cur)) {
+        return NANOCBOR_ERR_END;
+    }
+    *count = (size_t)entry->argument;
+    if (entry->type == NANOCBOR_TYPE_MAP) {
+        *count *= 2;
+    }
+    return NANOCBOR_OK;
+}
+
+/*
+ * Containers, tags and indefinite length strings are open until all their
+ * children are indexed. While open, the end member holds the number of
+ * children left and the next member the entry of the enclosing open item.
+ * This keeps the stack of open items inside the entry table itself.
+ */
+int nanocbor_index_build(nanocbor_index_t *index, const uint8_t *buf,
+                         size_t len)
+{
+    nanocbor_value_t it;
+    size_t open = INDEX_NONE;
+
+    nanocbor_decoder_init(&it, buf, len);
+    index->buf = buf;
+    index->len = len;
+    index->num = 0;
+    index->hint = 0;
+
+    while (!_over_end(&it) || open != INDEX_NONE) {
+        if (open != INDEX_NONE) {
+            nanocbor_index_entry_t *parent = &index->entries[open];
+            bool indefinite = parent->flags & NANOCBOR_INDEX_FLAG_INDEFINITE;
+            if (indefinite && !_over_end(&it)
+                && (_ib_table[*it.cur] & IB_BREAK)) {
+                it.cur++;
+            }
+            else if (indefinite || parent->end > 0) {
+                parent = NULL;
+            }
+            if (parent) {
+                /* All children indexed, close the item */
+                open = parent->next;
+                parent->next = index->num;
+                parent->end = (size_t)(it.cur - buf);
+                continue;
+            }
+        }
+        if (index->num == index->capacity) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+
+        int type = nanocbor_get_type(&it);
+        if (type < 0) {
+            return type;
+        }
+        nanocbor_index_entry_t *entry = &index->entries[index->num];
+        entry->offset = (size_t)(it.cur - buf);
+        entry->type = (uint8_t)type;
+        entry->flags = 0;
+        entry->argument = 0;
+
+        int res = 1;
+        if (_ib_table[*it.cur] & IB_INDEFINITE) {
+            entry->flags = NANOCBOR_INDEX_FLAG_INDEFINITE;
+        }
+        else {
+            res = _get_uint64(&it, &entry->argument, NANOCBOR_SIZE_LONG, type);
+            if (res < 0) {
+                return res;
+            }
+        }
+        it.cur += res;
+
+        if (open != INDEX_NONE
+            && !(index->entries[open].flags & NANOCBOR_INDEX_FLAG_INDEFINITE)) {
+            index->entries[open].end--;
+        }
+
+        if ((type == NANOCBOR_TYPE_BSTR || type == NANOCBOR_TYPE_TSTR)
+            && !(entry->flags & NANOCBOR_INDEX_FLAG_INDEFINITE)) {
+            if (entry->argument > (uint64_t)(it.end - it.cur)) {
+                return NANOCBOR_ERR_END;
+            }
+            it.cur += entry->argument;
+        }
+        else if (type == NANOCBOR_TYPE_ARR || type == NANOCBOR_TYPE_MAP
+                 || type == NANOCBOR_TYPE_TAG
+                 || (entry->flags & NANOCBOR_INDEX_FLAG_INDEFINITE)) {
+            res = _index_children(entry, &it, &entry->end);
+            if (res < 0) {
+                return res;
+            }
+            entry->next = open;
+            open = index->num++;
+            continue;
+        }
+        entry->end = (size_t)(it.cur - buf);
+        entry->next = ++index->num;
+    }
+    return (int)index->num;
+}
+
+const nanocbor_index_entry_t *nanocbor_index_lookup(nanocbor_index_t *index,
+                                                    const uint8_t *pos)
+{
+    if (pos < index->buf || pos >= index->buf + index->len) {
+        return NULL;
+    }
+    size_t offset = (size_t)(pos - index->buf);
+    size_t low = index->hint;
+
+    /* Sequential access hits the hint, binary search otherwise */
+    if (low >= index->num || index->entries[low].offset != offset) {
+        size_t high = index->num;
+        low = 0;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (index->entries[mid].offset < offset) {
+                low = mid + 1;
+            }
+            else {
+                high = mid;
+            }
+        }
+        if (low == index->num || index->entries[low].offset != offset) {
+            return NULL;
+        }
+    }
+    const nanocbor_index_entry_t *entry = &index->entries[low];
+    index->hint = entry->next;
+    return entry;
+}
+
+int nanocbor_index_skip(nanocbor_index_t *index, nanocbor_value_t *it)
+{
+    if (nanocbor_at_end(it)) {
+        return NANOCBOR_ERR_END;
+    }
+    const nanocbor_index_entry_t *entry = nanocbor_index_lookup(index, it->cur);
+    if (!entry) {
+        return nanocbor_skip(it);
+    }
+    const uint8_t *next = index->buf + entry->end;
+    if (next > it->end) {
+        return NANOCBOR_ERR_END;
+    }
+    it->cur = next;
+    it->remaining--;
+    return NANOCBOR_OK;
+}
+
+/*
+ * Entries are stored in document order and only link to the entry after their
+ * own subtree, so reaching sibling N takes N hops over the table. Only the
+ * first entry is looked up, the hops touch neither the buffer nor the search.
+ */
+int nanocbor_index_skip_items(nanocbor_index_t *index, nanocbor_value_t *it,
+                              size_t n)
+{
+    const nanocbor_index_entry_t *entry = NULL;
+
+    for (size_t i = 0; i < n; i++) {
+        if (nanocbor_at_end(it)) {
+            return NANOCBOR_ERR_END;
+        }
+        if (!entry || index->buf + entry->offset != it->cur) {
+            entry = nanocbor_index_lookup(index, it->cur);
+            if (!entry) {
+                int res = nanocbor_skip(it);
+                if (res < 0) {
+                    return res;
+                }
+                continue;
+            }
+        }
+        const uint8_t *next = index->buf + entry->end;
+        if (next > it->end) {
+            return NANOCBOR_ERR_END;
+        }
+        it->cur = next;
+        it->remaining--;
+        index->hint = entry->next;
+        entry = entry->next < index->num ? &index->entries[entry->next] : NULL;
+    }
+    return NANOCBOR_OK;
+}
+
+int nanocbor_index_get_key_tstr(nanocbor_index_t *index,
+                                nanocbor_value_t *start, const char *key,
+                                nanocbor_value_t *value)
+{
+    return _get_key_tstr(index, start, key, value);
+}
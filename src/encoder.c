@@ -22,6 +22,8 @@
 
 #include NANOCBOR_BYTEORDER_HEADER
 
+#include "internal.h"
+
 /* memarray functions */
 static bool _encoder_mem_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
 {
@@ -43,6 +45,8 @@ void nanocbor_encoder_init(nanocbor_encoder_t *enc, uint8_t *buf, size_t len)
     enc->end = buf + len;
     enc->append = _encoder_mem_append;
     enc->fits = _encoder_mem_fits;
+    enc->container = NULL;
+    enc->flags = NANOCBOR_ENCODER_FLAG_MEMORY;
 }
 
 void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
@@ -53,6 +57,222 @@ void nanocbor_encoder_stream_init(nanocbor_encoder_t *enc, void *ctx,
     enc->append = append_func;
     enc->fits = fits_func;
     enc->context = ctx;
+    enc->container = NULL;
+    enc->flags = 0;
+}
+
+/* growable buffer functions */
+static bool _encoder_grow_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    nanocbor_growbuf_t *grow = ctx;
+    (void)enc;
+
+    if (grow->capacity - grow->len >= len) {
+        return true;
+    }
+    if (len > SIZE_MAX / 2 - grow->len) {
+        return false;
+    }
+    /* Geometric growth keeps the number of reallocations logarithmic */
+    size_t capacity = grow->capacity ? grow->capacity : NANOCBOR_GROWBUF_MIN;
+    while (capacity - grow->len < len) {
+        capacity *= 2;
+    }
+    uint8_t *buf = grow->realloc_func
+        ? grow->realloc_func(grow->ctx, grow->buf, capacity)
+        : realloc(grow->buf, capacity);
+    if (buf == NULL) {
+        return false;
+    }
+    grow->buf = buf;
+    grow->capacity = capacity;
+    return true;
+}
+
+static void _encoder_grow_append(nanocbor_encoder_t *enc, void *ctx,
+                                 const uint8_t *data, size_t len)
+{
+    nanocbor_growbuf_t *grow = ctx;
+    (void)enc;
+
+    memcpy(grow->buf + grow->len, data, len);
+    grow->len += len;
+}
+
+void nanocbor_encoder_growable_init(nanocbor_encoder_t *enc,
+                                    nanocbor_growbuf_t *grow,
+                                    nanocbor_realloc_t realloc_func, void *ctx)
+{
+    grow->buf = NULL;
+    grow->len = 0;
+    grow->capacity = 0;
+    grow->realloc_func = realloc_func;
+    grow->ctx = ctx;
+    nanocbor_encoder_stream_init(enc, grow, _encoder_grow_append,
+                                 _encoder_grow_fits);
+}
+
+/* buffered stream functions */
+static bool _encoder_buf_flush(nanocbor_encoder_t *enc,
+                               nanocbor_stream_buf_t *stream)
+{
+    if (stream->used == 0) {
+        return true;
+    }
+    if (!stream->fits(enc, stream->ctx, stream->used)) {
+        return false;
+    }
+    stream->append(enc, stream->ctx, stream->buf, stream->used);
+    stream->used = 0;
+    return true;
+}
+
+static bool _encoder_buf_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    nanocbor_stream_buf_t *stream = ctx;
+
+    if (stream->size - stream->used >= len) {
+        return true;
+    }
+    if (!_encoder_buf_flush(enc, stream)) {
+        return false;
+    }
+    /* Large payloads bypass the staging buffer */
+    return len <= stream->size || stream->fits(enc, stream->ctx, len);
+}
+
+static void _encoder_buf_append(nanocbor_encoder_t *enc, void *ctx,
+                                const uint8_t *data, size_t len)
+{
+    nanocbor_stream_buf_t *stream = ctx;
+
+    if (stream->size - stream->used >= len) {
+        memcpy(stream->buf + stream->used, data, len);
+        stream->used += len;
+    }
+    else {
+        stream->append(enc, stream->ctx, data, len);
+    }
+}
+
+void nanocbor_encoder_buffered_init(nanocbor_encoder_t *enc,
+                                    nanocbor_stream_buf_t *stream,
+                                    uint8_t *buf, size_t size, void *ctx,
+                                    nanocbor_encoder_append append_func,
+                                    nanocbor_encoder_fits fits_func)
+{
+    stream->buf = buf;
+    stream->size = size;
+    stream->used = 0;
+    stream->append = append_func;
+    stream->fits = fits_func;
+    stream->ctx = ctx;
+    nanocbor_encoder_stream_init(enc, stream, _encoder_buf_append,
+                                 _encoder_buf_fits);
+}
+
+int nanocbor_encoder_flush(nanocbor_encoder_t *enc)
+{
+    if (enc->append != _encoder_buf_append) {
+        return NANOCBOR_OK;
+    }
+    return _encoder_buf_flush(enc, enc->context) ? NANOCBOR_OK
+                                                 : NANOCBOR_ERR_END;
+}
+
+/* vectored output functions */
+/* Whether copied data can be added to the last vector */
+static bool _iovec_extends(const nanocbor_iovec_buf_t *vec)
+{
+    if (vec->num == 0) {
+        return false;
+    }
+    const nanocbor_iovec_t *last = &vec->iov[vec->num - 1];
+    return (const uint8_t *)last->base + last->len == vec->buf + vec->used;
+}
+
+static bool _encoder_iovec_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    nanocbor_iovec_buf_t *vec = ctx;
+    (void)enc;
+
+    if (len >= vec->threshold) {
+        return vec->num < vec->max;
+    }
+    return vec->size - vec->used >= len
+        && (vec->num < vec->max || _iovec_extends(vec));
+}
+
+static void _encoder_iovec_append(nanocbor_encoder_t *enc, void *ctx,
+                                  const uint8_t *data, size_t len)
+{
+    nanocbor_iovec_buf_t *vec = ctx;
+    (void)enc;
+
+    /* Large payloads are referenced, not copied */
+    if (len >= vec->threshold) {
+        vec->iov[vec->num].base = data;
+        vec->iov[vec->num].len = len;
+        vec->num++;
+        return;
+    }
+    if (!_iovec_extends(vec)) {
+        vec->iov[vec->num].base = vec->buf + vec->used;
+        vec->iov[vec->num].len = 0;
+        vec->num++;
+    }
+    memcpy(vec->buf + vec->used, data, len);
+    vec->used += len;
+    vec->iov[vec->num - 1].len += len;
+}
+
+void nanocbor_encoder_iovec_init(nanocbor_encoder_t *enc,
+                                 nanocbor_iovec_buf_t *vec,
+                                 nanocbor_iovec_t *iov, size_t max,
+                                 uint8_t *buf, size_t size, size_t threshold)
+{
+    vec->iov = iov;
+    vec->max = max;
+    vec->num = 0;
+    vec->buf = buf;
+    vec->size = size;
+    vec->used = 0;
+    /* Headers are formatted on the stack and must always be copied */
+    vec->threshold = threshold > NANOCBOR_IOVEC_THRESHOLD_MIN
+        ? threshold
+        : NANOCBOR_IOVEC_THRESHOLD_MIN;
+    nanocbor_encoder_stream_init(enc, vec, _encoder_iovec_append,
+                                 _encoder_iovec_fits);
+}
+
+/* size only functions */
+static bool _encoder_size_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)len;
+    return true;
+}
+
+static void _encoder_size_append(nanocbor_encoder_t *enc, void *ctx,
+                                 const uint8_t *data, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)data;
+    (void)len;
+}
+
+void nanocbor_encoder_size_init(nanocbor_encoder_t *enc)
+{
+    nanocbor_encoder_stream_init(enc, NULL, _encoder_size_append,
+                                 _encoder_size_fits);
+    enc->flags = NANOCBOR_ENCODER_FLAG_SIZE;
+}
+
+void nanocbor_encoder_set_canonical(nanocbor_encoder_t *enc)
+{
+    enc->flags |= NANOCBOR_ENCODER_FLAG_CANONICAL;
 }
 
 size_t nanocbor_encoded_len(nanocbor_encoder_t *enc)
@@ -65,18 +285,48 @@ static inline void _incr_len(nanocbor_encoder_t *enc, size_t len)
     enc->len += len;
 }
 
+static inline bool _is_mem(const nanocbor_encoder_t *enc)
+{
+#if NANOCBOR_ENCODER_INLINE_MEMORY
+    return enc->flags & NANOCBOR_ENCODER_FLAG_MEMORY;
+#else
+    (void)enc;
+    return false;
+#endif
+}
+
+static inline bool _is_size_only(const nanocbor_encoder_t *enc)
+{
+    return enc->flags & NANOCBOR_ENCODER_FLAG_SIZE;
+}
+
+/* Memory buffers are written directly, avoiding the indirect calls */
 static inline void _append(nanocbor_encoder_t *enc, const uint8_t *data, size_t len)
 {
+    if (_is_size_only(enc)) {
+        return;
+    }
+    if (_is_mem(enc)) {
+        memcpy(enc->cur, data, len);
+        enc->cur += len;
+        return;
+    }
     enc->append(enc, enc->context, data, len);
 }
 
 static inline int _fits(nanocbor_encoder_t *enc, size_t len)
 {
-    return enc->fits(enc, enc->context, len) ? (int)len : NANOCBOR_ERR_END;
+    if (_is_size_only(enc)) {
+        return (int)len;
+    }
+    bool fits = _is_mem(enc) ? (size_t)(enc->end - enc->cur) >= len
+                             : enc->fits(enc, enc->context, len);
+    return fits ? (int)len : NANOCBOR_ERR_END;
 }
 
 static int _fmt_single(nanocbor_encoder_t *enc, uint8_t single)
 {
+    _count_item(enc, single, 0);
     _incr_len(enc, 1);
     int res = _fits(enc, 1);
 
@@ -95,48 +345,38 @@ int nanocbor_fmt_bool(nanocbor_encoder_t *enc, bool content)
     return _fmt_single(enc, single);
 }
 
-static int _fmt_uint64(nanocbor_encoder_t *enc, uint64_t num, uint8_t type)
+static int _fmt_arg(nanocbor_encoder_t *enc, uint64_t num, uint8_t type)
 {
-    unsigned extrabytes = 0;
+    unsigned extrabytes = _arg_size(num, &type);
 
-    if (num < NANOCBOR_SIZE_BYTE) {
-        type |= num;
-    }
-    else {
-        if (num > UINT32_MAX) {
-            /* Requires long size */
-            type |= NANOCBOR_SIZE_LONG;
-            extrabytes = sizeof(uint64_t);
-        }
-        else if (num > UINT16_MAX) {
-            /* At least word size */
-            type |= NANOCBOR_SIZE_WORD;
-            extrabytes = sizeof(uint32_t);
-        }
-        else if (num > UINT8_MAX) {
-            type |= NANOCBOR_SIZE_SHORT;
-            extrabytes = sizeof(uint16_t);
-        }
-        else {
-            type |= NANOCBOR_SIZE_BYTE;
-            extrabytes = sizeof(uint8_t);
-        }
-    }
+    _count_item(enc, type, num);
     _incr_len(enc, extrabytes + 1);
     int res = _fits(enc, extrabytes + 1);
-    if (res > 0) {
-        _append(enc, &type, 1);
-
-        /* NOLINTNEXTLINE: user supplied function */
-        uint64_t benum = NANOCBOR_HTOBE64_FUNC(num);
-
-
-        _append(enc, (uint8_t *)&benum + sizeof(benum) - extrabytes,
-               extrabytes);
+    if (res > 0 && !_is_size_only(enc)) {
+        /* Header and argument in a single append */
+        uint8_t tmp[1 + sizeof(uint64_t)];
+        _put_arg(tmp, num, type, extrabytes);
+        _append(enc, tmp, extrabytes + 1);
     }
     return res;
 }
 
+static inline int _fmt_uint64(nanocbor_encoder_t *enc, uint64_t num,
+                              uint8_t type)
+{
+    /* Small values in a memory buffer are a bounds check and a store */
+    if (num < NANOCBOR_SIZE_BYTE && _is_mem(enc)) {
+        _count_item(enc, type | (uint8_t)num, num);
+        _incr_len(enc, 1);
+        if (enc->cur == enc->end) {
+            return NANOCBOR_ERR_END;
+        }
+        *enc->cur++ = type | (uint8_t)num;
+        return 1;
+    }
+    return _fmt_arg(enc, num, type);
+}
+
 int nanocbor_fmt_uint(nanocbor_encoder_t *enc, uint64_t num)
 {
     return _fmt_uint64(enc, num, NANOCBOR_MASK_UINT);
@@ -199,6 +439,30 @@ int nanocbor_put_bstr(nanocbor_encoder_t *enc, const uint8_t *str, size_t len)
     return _put_bytes(enc, str, len);
 }
 
+int nanocbor_put_typed_array(nanocbor_encoder_t *enc, uint8_t tag,
+                             const void *elements, size_t num)
+{
+    size_t elem_size = nanocbor_typed_array_elem_size(tag);
+
+    if (elem_size == 0) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (num > SIZE_MAX / elem_size) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    if (elem_size > 1) {
+        /* NOLINTNEXTLINE: user supplied function */
+        if (NANOCBOR_HTOBE32_FUNC(1U) != 1U) {
+            tag |= NANOCBOR_TYPED_ARRAY_LE;
+        }
+        else {
+            tag &= (uint8_t)~NANOCBOR_TYPED_ARRAY_LE;
+        }
+    }
+    nanocbor_fmt_tag(enc, tag);
+    return nanocbor_put_bstr(enc, elements, num * elem_size);
+}
+
 int nanocbor_fmt_array(nanocbor_encoder_t *enc, size_t len)
 {
     return _fmt_uint64(enc, (uint64_t)len, NANOCBOR_MASK_ARR);
@@ -209,20 +473,30 @@ int nanocbor_fmt_map(nanocbor_encoder_t *enc, size_t len)
     return _fmt_uint64(enc, (uint64_t)len, NANOCBOR_MASK_MAP);
 }
 
+static int _fmt_indefinite(nanocbor_encoder_t *enc, uint8_t single)
+{
+    /* Deterministic encoding only allows definite lengths */
+    if (enc->flags & NANOCBOR_ENCODER_FLAG_CANONICAL) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return _fmt_single(enc, single);
+}
+
 int nanocbor_fmt_array_indefinite(nanocbor_encoder_t *enc)
 {
-    return _fmt_single(enc, NANOCBOR_MASK_ARR | NANOCBOR_SIZE_INDEFINITE);
+    return _fmt_indefinite(enc, NANOCBOR_MASK_ARR | NANOCBOR_SIZE_INDEFINITE);
 }
 
 int nanocbor_fmt_map_indefinite(nanocbor_encoder_t *enc)
 {
-    return _fmt_single(enc, NANOCBOR_MASK_MAP | NANOCBOR_SIZE_INDEFINITE);
+    return _fmt_indefinite(enc, NANOCBOR_MASK_MAP | NANOCBOR_SIZE_INDEFINITE);
 }
 
 int nanocbor_fmt_end_indefinite(nanocbor_encoder_t *enc)
 {
     /* End is marked with float major and indefinite minor number */
-    return _fmt_single(enc, NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_INDEFINITE);
+    return _fmt_indefinite(enc,
+                           NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_INDEFINITE);
 }
 
 int nanocbor_fmt_null(nanocbor_encoder_t *enc)
@@ -289,6 +563,7 @@ static bool _single_in_range(uint8_t exp, uint32_t num)
 
 static int _fmt_halffloat(nanocbor_encoder_t *enc, uint16_t half)
 {
+    _count_item(enc, NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_SHORT, 0);
     _incr_len(enc, sizeof(uint16_t) + 1);
     int res = _fits(enc, sizeof(uint16_t) + 1);
     if (res > 0) {
@@ -348,14 +623,16 @@ int nanocbor_fmt_float(nanocbor_encoder_t *enc, float num)
         return _fmt_halffloat(enc, half);
     }
     /* normal float */
+    _count_item(enc, NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_WORD, 0);
     _incr_len(enc, sizeof(float) + 1);
     int res = _fits(enc, 1 + sizeof(float));
     if (res > 0) {
-        const uint8_t tmp = NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_WORD;
-        _append(enc, &tmp, sizeof(tmp));
+        uint8_t tmp[1 + sizeof(float)] = { NANOCBOR_MASK_FLOAT
+                                           | NANOCBOR_SIZE_WORD };
         /* NOLINTNEXTLINE: user supplied function */
         uint32_t bnum = NANOCBOR_HTOBE32_FUNC(*unum);
-        _append(enc, (uint8_t*)&bnum, sizeof(bnum));
+        memcpy(tmp + 1, &bnum, sizeof(bnum));
+        _append(enc, tmp, sizeof(tmp));
     }
     return res;
 }
@@ -381,14 +658,16 @@ int nanocbor_fmt_double(nanocbor_encoder_t *enc, double num)
         float *fsingle = (float *)&single;
         return nanocbor_fmt_float(enc, *fsingle);
     }
+    _count_item(enc, NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_LONG, 0);
     _incr_len(enc, sizeof(double) + 1);
     int res = _fits(enc, 1 + sizeof(double));
     if (res > 0) {
-        const uint8_t tmp = NANOCBOR_MASK_FLOAT | NANOCBOR_SIZE_LONG;
-        _append(enc, &tmp, 1);
+        uint8_t tmp[1 + sizeof(double)] = { NANOCBOR_MASK_FLOAT
+                                            | NANOCBOR_SIZE_LONG };
         /* NOLINTNEXTLINE: user supplied function */
         uint64_t bnum = NANOCBOR_HTOBE64_FUNC(*unum);
-        _append(enc, (uint8_t*)&bnum, sizeof(bnum));
+        memcpy(tmp + 1, &bnum, sizeof(bnum));
+        _append(enc, tmp, sizeof(tmp));
     }
     return res;
 #endif
@@ -402,3 +681,141 @@ int nanocbor_fmt_decimal_frac(nanocbor_encoder_t *enc, int32_t e, int32_t m)
     res += nanocbor_fmt_int(enc, m);
     return res;
 }
+
+size_t nanocbor_size_uint(uint64_t num)
+{
+    uint8_t type = 0;
+    return 1 + _arg_size(num, &type);
+}
+
+size_t nanocbor_size_int(int64_t num)
+{
+    return nanocbor_size_uint(num < 0 ? (uint64_t)(-(num + 1)) : (uint64_t)num);
+}
+
+size_t nanocbor_size_str(size_t len)
+{
+    return nanocbor_size_uint((uint64_t)len) + len;
+}
+
+size_t nanocbor_size_float(float num)
+{
+    uint32_t *unum = (uint32_t *)&num;
+    uint8_t exp = (*unum >> FLOAT_EXP_POS) & FLOAT_EXP_MASK;
+
+    if (_single_is_inf_nan(exp) || _single_is_zero(*unum)
+        || _single_in_range(exp, *unum)) {
+        return 1 + sizeof(uint16_t);
+    }
+    return 1 + sizeof(float);
+}
+
+size_t nanocbor_size_double(double num)
+{
+#if __SIZEOF_DOUBLE__ == __SIZEOF_FLOAT__
+    return nanocbor_size_float(num);
+#else
+    uint64_t *unum = (uint64_t *)&num;
+    uint16_t exp = (*unum >> DOUBLE_EXP_POS) & DOUBLE_EXP_MASK;
+
+    /* Exactly representable as single precision */
+    if (_double_is_inf_nan(exp) || _double_is_zero(*unum)
+        || _double_in_range(exp, *unum)) {
+        return nanocbor_size_float((float)num);
+    }
+    return 1 + sizeof(double);
+#endif
+}
+
+int nanocbor_reserve(nanocbor_encoder_t *enc, size_t len)
+{
+    /* Unchecked functions write the buffer directly */
+    if (!(enc->flags & NANOCBOR_ENCODER_FLAG_MEMORY)) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    /* Every item staged for a sorted map also takes index space below the
+     * end of the buffer, which the unchecked writes would overrun */
+    if (enc->container && enc->container->indexed) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    return (size_t)(enc->end - enc->cur) >= len ? NANOCBOR_OK
+                                                : NANOCBOR_ERR_END;
+}
+
+static inline void _fmt_uint64_unchecked(nanocbor_encoder_t *enc,
+                                         uint64_t num, uint8_t type)
+{
+    unsigned extrabytes = _arg_size(num, &type);
+
+    _count_item(enc, type, num);
+    _put_arg(enc->cur, num, type, extrabytes);
+    enc->cur += extrabytes + 1;
+    _incr_len(enc, extrabytes + 1);
+}
+
+static inline void _put_bytes_unchecked(nanocbor_encoder_t *enc,
+                                        const uint8_t *buf, size_t len)
+{
+    memcpy(enc->cur, buf, len);
+    enc->cur += len;
+    _incr_len(enc, len);
+}
+
+void nanocbor_fmt_uint_unchecked(nanocbor_encoder_t *enc, uint64_t num)
+{
+    _fmt_uint64_unchecked(enc, num, NANOCBOR_MASK_UINT);
+}
+
+void nanocbor_fmt_int_unchecked(nanocbor_encoder_t *enc, int64_t num)
+{
+    if (num < 0) {
+        _fmt_uint64_unchecked(enc, (uint64_t)(-(num + 1)), NANOCBOR_MASK_NINT);
+    }
+    else {
+        _fmt_uint64_unchecked(enc, (uint64_t)num, NANOCBOR_MASK_UINT);
+    }
+}
+
+void nanocbor_fmt_tag_unchecked(nanocbor_encoder_t *enc, uint64_t num)
+{
+    _fmt_uint64_unchecked(enc, num, NANOCBOR_MASK_TAG);
+}
+
+void nanocbor_fmt_array_unchecked(nanocbor_encoder_t *enc, size_t len)
+{
+    _fmt_uint64_unchecked(enc, (uint64_t)len, NANOCBOR_MASK_ARR);
+}
+
+void nanocbor_fmt_map_unchecked(nanocbor_encoder_t *enc, size_t len)
+{
+    _fmt_uint64_unchecked(enc, (uint64_t)len, NANOCBOR_MASK_MAP);
+}
+
+void nanocbor_fmt_bool_unchecked(nanocbor_encoder_t *enc, bool content)
+{
+    uint8_t single = NANOCBOR_MASK_FLOAT
+        | (content ? NANOCBOR_SIMPLE_TRUE : NANOCBOR_SIMPLE_FALSE);
+    _count_item(enc, single, 0);
+    _put_bytes_unchecked(enc, &single, 1);
+}
+
+void nanocbor_fmt_null_unchecked(nanocbor_encoder_t *enc)
+{
+    static const uint8_t single = NANOCBOR_MASK_FLOAT | NANOCBOR_SIMPLE_NULL;
+    _count_item(enc, single, 0);
+    _put_bytes_unchecked(enc, &single, 1);
+}
+
+void nanocbor_put_bstr_unchecked(nanocbor_encoder_t *enc, const uint8_t *str,
+                                 size_t len)
+{
+    _fmt_uint64_unchecked(enc, (uint64_t)len, NANOCBOR_MASK_BSTR);
+    _put_bytes_unchecked(enc, str, len);
+}
+
+void nanocbor_put_tstrn_unchecked(nanocbor_encoder_t *enc, const char *str,
+                                  size_t len)
+{
+    _fmt_uint64_unchecked(enc, (uint64_t)len, NANOCBOR_MASK_TSTR);
+    _put_bytes_unchecked(enc, (const uint8_t *)str, len);
+}
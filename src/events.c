@@ -0,0 +1,236 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Event driven CBOR parser
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+/* Stack entry flags next to the decoder flags */
+#define EVENT_FLAG_TSTR (0x20U)
+#define EVENT_FLAG_MAP (0x40U)
+#define EVENT_FLAG_CHUNKS (0x80U)
+
+#define BREAK_MARKER                                                           \
+    ((NANOCBOR_TYPE_FLOAT << NANOCBOR_TYPE_OFFSET) | NANOCBOR_SIZE_INDEFINITE)
+
+static int _end_event(const nanocbor_callbacks_t *cb, void *ctx, uint8_t flags)
+{
+    if (flags & EVENT_FLAG_CHUNKS) {
+        return cb->on_end_chunks ? cb->on_end_chunks(ctx) : NANOCBOR_OK;
+    }
+    if (flags & EVENT_FLAG_MAP) {
+        return cb->on_end_map ? cb->on_end_map(ctx) : NANOCBOR_OK;
+    }
+    return cb->on_end_array ? cb->on_end_array(ctx) : NANOCBOR_OK;
+}
+
+/* Pop all containers that are exhausted, firing their end events */
+static int _leave(nanocbor_value_t *it, nanocbor_stack_entry_t *stack,
+                  size_t *level, const nanocbor_callbacks_t *cb, void *ctx)
+{
+    while (*level > 0) {
+        const nanocbor_stack_entry_t *top = &stack[*level - 1];
+        if (top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+            if (nanocbor_at_end(it)) {
+                return NANOCBOR_ERR_END;
+            }
+            if (*it->cur != BREAK_MARKER) {
+                break;
+            }
+            /* A break marker directly after a map key */
+            if ((top->flags & EVENT_FLAG_MAP) && (top->remaining & 1U)) {
+                return NANOCBOR_ERR_INVALID_TYPE;
+            }
+            it->cur++;
+        }
+        else if (top->remaining > 0) {
+            break;
+        }
+        (*level)--;
+        int res = _end_event(cb, ctx, top->flags);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return NANOCBOR_OK;
+}
+
+static int _string_event(nanocbor_value_t *it, const nanocbor_header_t *header,
+                         const nanocbor_callbacks_t *cb, void *ctx)
+{
+    const uint8_t *buf = it->cur + header->len;
+    int res = nanocbor_advance_header(it, header);
+    if (res < 0) {
+        return res;
+    }
+    int (*event)(void *, const uint8_t *, size_t)
+        = header->type == NANOCBOR_TYPE_TSTR ? cb->on_tstr : cb->on_bstr;
+    return event ? event(ctx, buf, (size_t)header->value) : NANOCBOR_OK;
+}
+
+static int _start_event(nanocbor_value_t *it, const nanocbor_header_t *header,
+                        nanocbor_stack_entry_t *entry,
+                        const nanocbor_callbacks_t *cb, void *ctx)
+{
+    uint64_t items = header->value;
+
+    entry->remaining = 0;
+    entry->flags = NANOCBOR_DECODER_FLAG_CONTAINER;
+    if (header->indefinite) {
+        entry->flags |= NANOCBOR_DECODER_FLAG_INDEFINITE;
+    }
+    /* Every item requires at least a single byte */
+    else if (items > (uint64_t)(it->end - it->cur)) {
+        return NANOCBOR_ERR_END;
+    }
+    it->cur += header->len;
+
+    switch (header->type) {
+    case NANOCBOR_TYPE_BSTR:
+    case NANOCBOR_TYPE_TSTR:
+        entry->flags |= EVENT_FLAG_CHUNKS;
+        if (header->type == NANOCBOR_TYPE_TSTR) {
+            entry->flags |= EVENT_FLAG_TSTR;
+        }
+        return cb->on_start_chunks ? cb->on_start_chunks(ctx, header->type)
+                                   : NANOCBOR_OK;
+    case NANOCBOR_TYPE_MAP:
+        entry->flags |= EVENT_FLAG_MAP;
+        entry->remaining = items * 2;
+        return cb->on_start_map
+            ? cb->on_start_map(ctx, items, header->indefinite)
+            : NANOCBOR_OK;
+    default:
+        entry->remaining = items;
+        return cb->on_start_array
+            ? cb->on_start_array(ctx, items, header->indefinite)
+            : NANOCBOR_OK;
+    }
+}
+
+static int _event(nanocbor_value_t *it, const nanocbor_header_t *header,
+                  const nanocbor_callbacks_t *cb, void *ctx)
+{
+    int res = NANOCBOR_OK;
+
+    switch (header->type) {
+    case NANOCBOR_TYPE_UINT:
+    case NANOCBOR_TYPE_NINT:
+    case NANOCBOR_TYPE_TAG: {
+        res = nanocbor_advance_header(it, header);
+        int (*event)(void *, uint64_t) = header->type == NANOCBOR_TYPE_UINT
+            ? cb->on_uint
+            : (header->type == NANOCBOR_TYPE_NINT ? cb->on_nint : cb->on_tag);
+        if (res == NANOCBOR_OK && event) {
+            res = event(ctx, header->value);
+        }
+    } break;
+    case NANOCBOR_TYPE_BSTR:
+    case NANOCBOR_TYPE_TSTR:
+        res = _string_event(it, header, cb, ctx);
+        break;
+    default:
+        /* Floating point values have a header of 3, 5 or 9 bytes */
+        if (header->len > 2) {
+            double value = 0;
+            res = nanocbor_get_double(it, &value);
+            if (res >= 0) {
+                res = cb->on_float ? cb->on_float(ctx, value) : NANOCBOR_OK;
+            }
+        }
+        else {
+            res = nanocbor_advance_header(it, header);
+            if (res == NANOCBOR_OK && cb->on_simple) {
+                res = cb->on_simple(ctx, (uint8_t)header->value);
+            }
+        }
+        break;
+    }
+    return res;
+}
+
+int nanocbor_parse_events_stack(const uint8_t *buf, size_t len,
+                                const nanocbor_callbacks_t *cb, void *ctx,
+                                nanocbor_stack_entry_t *stack, size_t depth)
+{
+    nanocbor_value_t it;
+    size_t level = 0;
+    bool tagged = false;
+
+    nanocbor_decoder_init(&it, buf, len);
+    while (true) {
+        int res = NANOCBOR_OK;
+        /* A tag is always followed by its content */
+        if (!tagged) {
+            res = _leave(&it, stack, &level, cb, ctx);
+            if (res < 0) {
+                return res;
+            }
+            if (level == 0 && nanocbor_at_end(&it)) {
+                return NANOCBOR_OK;
+            }
+        }
+
+        nanocbor_header_t header;
+        res = nanocbor_peek_header(&it, &header);
+        if (res < 0) {
+            return res;
+        }
+
+        nanocbor_stack_entry_t *top = level > 0 ? &stack[level - 1] : NULL;
+        /* Chunks of indefinite length strings are definite length strings of
+         * the same type */
+        if (top && (top->flags & EVENT_FLAG_CHUNKS)
+            && (header.indefinite
+                || header.type
+                    != ((top->flags & EVENT_FLAG_TSTR) ? NANOCBOR_TYPE_TSTR
+                                                       : NANOCBOR_TYPE_BSTR))) {
+            return NANOCBOR_ERR_INVALID_TYPE;
+        }
+        /* A tag and its content form a single item, indefinite length maps
+         * count their items to check the key/value parity */
+        if (top && header.type != NANOCBOR_TYPE_TAG) {
+            if (!(top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE)) {
+                top->remaining--;
+            }
+            else if (top->flags & EVENT_FLAG_MAP) {
+                top->remaining++;
+            }
+        }
+
+        if (header.indefinite || header.type == NANOCBOR_TYPE_ARR
+            || header.type == NANOCBOR_TYPE_MAP) {
+            if (level == depth) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            res = _start_event(&it, &header, &stack[level], cb, ctx);
+            level++;
+        }
+        else {
+            res = _event(&it, &header, cb, ctx);
+        }
+        if (res < 0) {
+            return res;
+        }
+        tagged = header.type == NANOCBOR_TYPE_TAG;
+    }
+}
+
+int nanocbor_parse_events(const uint8_t *buf, size_t len,
+                          const nanocbor_callbacks_t *cb, void *ctx)
+{
+    nanocbor_stack_entry_t stack[NANOCBOR_RECURSION_MAX];
+    return nanocbor_parse_events_stack(buf, len, cb, ctx, stack,
+                                       NANOCBOR_RECURSION_MAX);
+}
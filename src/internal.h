@@ -0,0 +1,91 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Helpers shared between the NanoCBOR source files, not installed
+ * @}
+ */
+
+#ifndef NANOCBOR_INTERNAL_H
+#define NANOCBOR_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#include NANOCBOR_BYTEORDER_HEADER
+
+/* 32 bit FNV-1a, must match tools/nanocbor_struct_gen.py */
+#define FNV_OFFSET_BASIS (2166136261U)
+#define FNV_PRIME (16777619U)
+
+static inline uint32_t _hash_fnv1a(uint32_t seed, const uint8_t *buf,
+                                   size_t len)
+{
+    uint32_t hash = FNV_OFFSET_BASIS ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= buf[i];
+        hash *= FNV_PRIME;
+    }
+    /* Mix the high bits into the low bits used for the slot */
+    return hash ^ (hash >> 16U);
+}
+
+/* Add the size to @p type, returns the number of argument bytes */
+static inline unsigned _arg_size(uint64_t num, uint8_t *type)
+{
+    if (num < NANOCBOR_SIZE_BYTE) {
+        *type |= num;
+        return 0;
+    }
+    if (num > UINT32_MAX) {
+        /* Requires long size */
+        *type |= NANOCBOR_SIZE_LONG;
+        return sizeof(uint64_t);
+    }
+    if (num > UINT16_MAX) {
+        /* At least word size */
+        *type |= NANOCBOR_SIZE_WORD;
+        return sizeof(uint32_t);
+    }
+    if (num > UINT8_MAX) {
+        *type |= NANOCBOR_SIZE_SHORT;
+        return sizeof(uint16_t);
+    }
+    *type |= NANOCBOR_SIZE_BYTE;
+    return sizeof(uint8_t);
+}
+
+/* Write the initial byte @p type and @p extrabytes argument bytes */
+static inline void _put_arg(uint8_t *dst, uint64_t num, uint8_t type,
+                            unsigned extrabytes)
+{
+    /* NOLINTNEXTLINE: user supplied function */
+    uint64_t benum = NANOCBOR_HTOBE64_FUNC(num);
+
+    dst[0] = type;
+    memcpy(dst + 1, (uint8_t *)&benum + sizeof(benum) - extrabytes,
+           extrabytes);
+}
+
+/* Account an item with initial byte @p ib and argument @p num to the
+ * innermost open container of @p enc, implemented in container.c */
+void nanocbor_container_item(nanocbor_encoder_t *enc, uint8_t ib,
+                             uint64_t num);
+
+static inline void _count_item(nanocbor_encoder_t *enc, uint8_t ib,
+                               uint64_t num)
+{
+    if (enc->container) {
+        nanocbor_container_item(enc, ib, num);
+    }
+}
+
+#endif /* NANOCBOR_INTERNAL_H */
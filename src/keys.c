@@ -0,0 +1,140 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Duplicate map key detection
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#include "internal.h"
+
+/* Total order on the encoded keys, only equality is meaningful for CBOR */
+static int _key_cmp(const nanocbor_key_slot_t *a, const nanocbor_key_slot_t *b)
+{
+    if (a->len != b->len) {
+        return a->len < b->len ? -1 : 1;
+    }
+    return memcmp(a->key, b->key, a->len);
+}
+
+/* Open addressing with linear probing, returns false on a duplicate */
+static bool _insert(nanocbor_key_slot_t *table, size_t size,
+                    const nanocbor_key_slot_t *key)
+{
+    size_t slot = _hash_fnv1a(0, key->key, key->len) % size;
+    while (table[slot].key != NULL) {
+        if (_key_cmp(&table[slot], key) == 0) {
+            return false;
+        }
+        slot = slot + 1 < size ? slot + 1 : 0;
+    }
+    table[slot] = *key;
+    return true;
+}
+
+/* Move the occupied slots to the front of the table */
+static void _compact(nanocbor_key_slot_t *table, size_t size)
+{
+    size_t num = 0;
+    for (size_t slot = 0; slot < size; slot++) {
+        if (table[slot].key != NULL) {
+            table[num++] = table[slot];
+        }
+    }
+}
+
+static void _sift_down(nanocbor_key_slot_t *keys, size_t root, size_t num)
+{
+    while (2 * root + 1 < num) {
+        size_t child = 2 * root + 1;
+        if (child + 1 < num && _key_cmp(&keys[child], &keys[child + 1]) < 0) {
+            child++;
+        }
+        if (_key_cmp(&keys[root], &keys[child]) >= 0) {
+            return;
+        }
+        nanocbor_key_slot_t tmp = keys[root];
+        keys[root] = keys[child];
+        keys[child] = tmp;
+        root = child;
+    }
+}
+
+/* Heap sort, in place and without recursion */
+static void _sort(nanocbor_key_slot_t *keys, size_t num)
+{
+    for (size_t i = num / 2; i > 0; i--) {
+        _sift_down(keys, i - 1, num);
+    }
+    for (size_t end = num; end > 1; end--) {
+        nanocbor_key_slot_t tmp = keys[0];
+        keys[0] = keys[end - 1];
+        keys[end - 1] = tmp;
+        _sift_down(keys, 0, end - 1);
+    }
+}
+
+int nanocbor_check_map_keys(const nanocbor_value_t *it,
+                            nanocbor_key_slot_t *table, size_t size)
+{
+    nanocbor_value_t map;
+    size_t num = 0;
+    /* Keep the load factor of the hash table at or below one half */
+    bool hashed = true;
+
+    int res = nanocbor_enter_map(it, &map);
+    if (res < 0) {
+        return res;
+    }
+    for (size_t slot = 0; slot < size; slot++) {
+        table[slot].key = NULL;
+    }
+    while (!nanocbor_at_end(&map)) {
+        nanocbor_key_slot_t key;
+        res = nanocbor_get_subcbor(&map, &key.key, &key.len);
+        if (res < 0) {
+            return res;
+        }
+        res = nanocbor_skip(&map);
+        if (res < 0) {
+            return res;
+        }
+        if (num == size) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        if (hashed && 2 * (num + 1) > size) {
+            /* Too many keys for hashing, collect them for sorting */
+            _compact(table, size);
+            hashed = false;
+        }
+        if (hashed) {
+            if (!_insert(table, size, &key)) {
+                return NANOCBOR_ERR_DUPLICATE_KEY;
+            }
+        }
+        else {
+            table[num] = key;
+        }
+        num++;
+    }
+    if (!hashed) {
+        _sort(table, num);
+        for (size_t i = 1; i < num; i++) {
+            if (_key_cmp(&table[i - 1], &table[i]) == 0) {
+                return NANOCBOR_ERR_DUPLICATE_KEY;
+            }
+        }
+    }
+    return NANOCBOR_OK;
+}
@@ -0,0 +1,477 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Decoder for CBOR split over a list of buffer segments
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+/* Largest header, the initial byte followed by a 64 bit argument */
+#define HEADER_MAX (1U + sizeof(uint64_t))
+
+#define BREAK_MARKER                                                           \
+    ((NANOCBOR_TYPE_FLOAT << NANOCBOR_TYPE_OFFSET) | NANOCBOR_SIZE_INDEFINITE)
+
+/* Move past exhausted and empty segments */
+static void _normalize(nanocbor_seg_value_t *it)
+{
+    while (it->seg < it->num && it->off == it->segs[it->seg].len) {
+        it->seg++;
+        it->off = 0;
+    }
+}
+
+/* Copy up to @p len bytes from the current position without consuming them */
+static size_t _peek(const nanocbor_seg_value_t *it, uint8_t *dst, size_t len)
+{
+    size_t copied = 0;
+    size_t off = it->off;
+
+    for (size_t seg = it->seg; seg < it->num && copied < len; seg++) {
+        size_t avail = it->segs[seg].len - off;
+        size_t num = avail < len - copied ? avail : len - copied;
+        memcpy(dst + copied, (const uint8_t *)it->segs[seg].base + off, num);
+        copied += num;
+        off = 0;
+    }
+    return copied;
+}
+
+static int _consume(nanocbor_seg_value_t *it, uint64_t len)
+{
+    while (len > 0) {
+        if (it->seg == it->num) {
+            return NANOCBOR_ERR_END;
+        }
+        size_t avail = it->segs[it->seg].len - it->off;
+        size_t num = avail < len ? avail : (size_t)len;
+        it->off += num;
+        len -= num;
+        _normalize(it);
+    }
+    return NANOCBOR_OK;
+}
+
+static void _item_done(nanocbor_seg_value_t *it)
+{
+    if (it->remaining) {
+        it->remaining--;
+    }
+}
+
+void nanocbor_seg_decoder_init(nanocbor_seg_value_t *it,
+                               const nanocbor_iovec_t *segs, size_t num)
+{
+    it->segs = segs;
+    it->num = num;
+    it->seg = 0;
+    it->off = 0;
+    it->remaining = 0;
+    it->flags = 0;
+    _normalize(it);
+}
+
+bool nanocbor_seg_at_end(const nanocbor_seg_value_t *it)
+{
+    uint8_t byte = 0;
+    if (_peek(it, &byte, 1) == 0) {
+        return true;
+    }
+    if (!(it->flags & NANOCBOR_DECODER_FLAG_CONTAINER)) {
+        return false;
+    }
+    if (it->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+        return byte == BREAK_MARKER;
+    }
+    return it->remaining == 0;
+}
+
+int nanocbor_seg_peek_header(const nanocbor_seg_value_t *it,
+                             nanocbor_header_t *header)
+{
+    uint8_t buf[HEADER_MAX];
+    nanocbor_value_t tmp;
+
+    if (nanocbor_seg_at_end(it)) {
+        return NANOCBOR_ERR_END;
+    }
+    /* Headers straddling a segment boundary are decoded from a copy */
+    nanocbor_decoder_init(&tmp, buf, _peek(it, buf, sizeof(buf)));
+    return nanocbor_peek_header(&tmp, header);
+}
+
+/* Consume a header and string contents, without counting the item */
+static int _advance_header(nanocbor_seg_value_t *it,
+                           const nanocbor_header_t *header)
+{
+    if (header->indefinite || header->type == NANOCBOR_TYPE_ARR
+        || header->type == NANOCBOR_TYPE_MAP) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    uint64_t len = header->len;
+    if (header->type == NANOCBOR_TYPE_BSTR
+        || header->type == NANOCBOR_TYPE_TSTR) {
+        len += header->value;
+    }
+    nanocbor_seg_value_t tmp = *it;
+    int res = _consume(&tmp, len);
+    if (res == NANOCBOR_OK) {
+        *it = tmp;
+    }
+    return res;
+}
+
+int nanocbor_seg_advance_header(nanocbor_seg_value_t *it,
+                                const nanocbor_header_t *header)
+{
+    int res = _advance_header(it, header);
+    /* A tag and its content form a single item */
+    if (res == NANOCBOR_OK && header->type != NANOCBOR_TYPE_TAG) {
+        _item_done(it);
+    }
+    return res;
+}
+
+static int _get_arg(nanocbor_seg_value_t *it, uint64_t *value, uint8_t type)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_seg_peek_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    if (header.type != type || header.indefinite) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    res = nanocbor_seg_advance_header(it, &header);
+    *value = header.value;
+    return res < 0 ? res : header.len;
+}
+
+int nanocbor_seg_get_uint64(nanocbor_seg_value_t *it, uint64_t *value)
+{
+    return _get_arg(it, value, NANOCBOR_TYPE_UINT);
+}
+
+int nanocbor_seg_get_int64(nanocbor_seg_value_t *it, int64_t *value)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_seg_peek_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    if (header.type != NANOCBOR_TYPE_UINT && header.type != NANOCBOR_TYPE_NINT) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (header.value > INT64_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    res = nanocbor_seg_advance_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    *value = header.type == NANOCBOR_TYPE_UINT ? (int64_t)header.value
+                                               : -1 - (int64_t)header.value;
+    return header.len;
+}
+
+int nanocbor_seg_get_tag(nanocbor_seg_value_t *it, uint32_t *tag)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_seg_peek_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    if (header.type != NANOCBOR_TYPE_TAG) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (header.value > UINT32_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    res = nanocbor_seg_advance_header(it, &header);
+    if (res == NANOCBOR_OK) {
+        *tag = (uint32_t)header.value;
+    }
+    return res;
+}
+
+static int _get_str(nanocbor_seg_value_t *it, const uint8_t **buf,
+                    size_t *len, uint8_t *scratch, size_t size, uint8_t type)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_seg_peek_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    if (header.type != type || header.indefinite) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    if (header.value > SIZE_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+
+    nanocbor_seg_value_t start = *it;
+    res = _consume(&start, header.len);
+    if (res < 0) {
+        return res;
+    }
+    size_t str_len = (size_t)header.value;
+    if (start.seg < start.num
+        && start.segs[start.seg].len - start.off >= str_len) {
+        /* Within a single segment, no copy required */
+        *buf = (const uint8_t *)start.segs[start.seg].base + start.off;
+    }
+    else if (str_len > size) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    else if (_peek(&start, scratch, str_len) < str_len) {
+        return NANOCBOR_ERR_END;
+    }
+    else {
+        *buf = scratch;
+    }
+    *len = str_len;
+    return nanocbor_seg_advance_header(it, &header);
+}
+
+int nanocbor_seg_get_bstr(nanocbor_seg_value_t *it, const uint8_t **buf,
+                          size_t *len, uint8_t *scratch, size_t size)
+{
+    return _get_str(it, buf, len, scratch, size, NANOCBOR_TYPE_BSTR);
+}
+
+int nanocbor_seg_get_tstr(nanocbor_seg_value_t *it, const uint8_t **buf,
+                          size_t *len, uint8_t *scratch, size_t size)
+{
+    return _get_str(it, buf, len, scratch, size, NANOCBOR_TYPE_TSTR);
+}
+
+/* Set up @p tmp over a copy of the next header, headers straddling a
+ * segment boundary are decoded like any other */
+static int _peek_value(const nanocbor_seg_value_t *it, nanocbor_value_t *tmp,
+                       uint8_t *buf)
+{
+    if (nanocbor_seg_at_end(it)) {
+        return NANOCBOR_ERR_END;
+    }
+    nanocbor_decoder_init(tmp, buf, _peek(it, buf, HEADER_MAX));
+    return NANOCBOR_OK;
+}
+
+/* Consume the bytes decoded from the copy as a single item */
+static int _advance_value(nanocbor_seg_value_t *it,
+                          const nanocbor_value_t *tmp, const uint8_t *buf,
+                          int res)
+{
+    if (res >= 0) {
+        _consume(it, (uint64_t)(tmp->cur - buf));
+        _item_done(it);
+    }
+    return res;
+}
+
+int nanocbor_seg_get_float(nanocbor_seg_value_t *it, float *value)
+{
+    uint8_t buf[HEADER_MAX];
+    nanocbor_value_t tmp;
+    int res = _peek_value(it, &tmp, buf);
+
+    if (res == NANOCBOR_OK) {
+        res = nanocbor_get_float(&tmp, value);
+    }
+    return _advance_value(it, &tmp, buf, res);
+}
+
+int nanocbor_seg_get_double(nanocbor_seg_value_t *it, double *value)
+{
+    uint8_t buf[HEADER_MAX];
+    nanocbor_value_t tmp;
+    int res = _peek_value(it, &tmp, buf);
+
+    if (res == NANOCBOR_OK) {
+        res = nanocbor_get_double(&tmp, value);
+    }
+    return _advance_value(it, &tmp, buf, res);
+}
+
+int nanocbor_seg_get_bool(nanocbor_seg_value_t *it, bool *value)
+{
+    uint8_t buf[HEADER_MAX];
+    nanocbor_value_t tmp;
+    int res = _peek_value(it, &tmp, buf);
+
+    if (res == NANOCBOR_OK) {
+        res = nanocbor_get_bool(&tmp, value);
+    }
+    return _advance_value(it, &tmp, buf, res);
+}
+
+int nanocbor_seg_get_null(nanocbor_seg_value_t *it)
+{
+    uint8_t buf[HEADER_MAX];
+    nanocbor_value_t tmp;
+    int res = _peek_value(it, &tmp, buf);
+
+    if (res == NANOCBOR_OK) {
+        res = nanocbor_get_null(&tmp);
+    }
+    return _advance_value(it, &tmp, buf, res);
+}
+
+static int _enter_container(const nanocbor_seg_value_t *it,
+                            nanocbor_seg_value_t *container, uint8_t type)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_seg_peek_header(it, &header);
+    if (res < 0) {
+        return res;
+    }
+    if (header.type != type) {
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+    *container = *it;
+    container->flags = NANOCBOR_DECODER_FLAG_CONTAINER;
+    container->remaining = 0;
+    if (header.indefinite) {
+        container->flags |= NANOCBOR_DECODER_FLAG_INDEFINITE;
+    }
+    else if (type == NANOCBOR_TYPE_MAP) {
+        if (header.value > UINT64_MAX / 2) {
+            return NANOCBOR_ERR_OVERFLOW;
+        }
+        container->remaining = header.value * 2;
+    }
+    else {
+        container->remaining = header.value;
+    }
+    return _consume(container, header.len);
+}
+
+int nanocbor_seg_enter_array(const nanocbor_seg_value_t *it,
+                             nanocbor_seg_value_t *array)
+{
+    return _enter_container(it, array, NANOCBOR_TYPE_ARR);
+}
+
+int nanocbor_seg_enter_map(const nanocbor_seg_value_t *it,
+                           nanocbor_seg_value_t *map)
+{
+    return _enter_container(it, map, NANOCBOR_TYPE_MAP);
+}
+
+void nanocbor_seg_leave_container(nanocbor_seg_value_t *it,
+                                  nanocbor_seg_value_t *container)
+{
+    uint8_t flags = it->flags;
+    uint64_t remaining = it->remaining;
+
+    *it = *container;
+    it->flags = flags;
+    it->remaining = remaining;
+    if (container->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+        /* Skip the break marker */
+        _consume(it, 1);
+    }
+    _item_done(it);
+}
+
+int nanocbor_seg_skip_stack(nanocbor_seg_value_t *it,
+                            nanocbor_stack_entry_t *stack, size_t depth)
+{
+    nanocbor_seg_value_t walker = *it;
+    /* The item to skip is the single item of an implicit outer container */
+    uint64_t outer = 1;
+    size_t level = 0;
+
+    if (nanocbor_seg_at_end(it)) {
+        return NANOCBOR_ERR_END;
+    }
+    while (true) {
+        /* Leave exhausted containers */
+        while (level > 0) {
+            nanocbor_stack_entry_t *top = &stack[level - 1];
+            if (top->flags & NANOCBOR_DECODER_FLAG_INDEFINITE) {
+                uint8_t byte = 0;
+                if (_peek(&walker, &byte, 1) == 0) {
+                    return NANOCBOR_ERR_END;
+                }
+                if (byte != BREAK_MARKER) {
+                    break;
+                }
+                _consume(&walker, 1);
+            }
+            else if (top->remaining > 0) {
+                break;
+            }
+            level--;
+        }
+        if (level == 0 && outer == 0) {
+            break;
+        }
+
+        nanocbor_header_t header;
+        uint8_t buf[HEADER_MAX];
+        nanocbor_value_t tmp;
+        nanocbor_decoder_init(&tmp, buf, _peek(&walker, buf, sizeof(buf)));
+        int res = nanocbor_peek_header(&tmp, &header);
+        if (res < 0) {
+            return res;
+        }
+        if (header.type != NANOCBOR_TYPE_TAG) {
+            if (level == 0) {
+                outer--;
+            }
+            else if (!(stack[level - 1].flags
+                       & NANOCBOR_DECODER_FLAG_INDEFINITE)) {
+                stack[level - 1].remaining--;
+            }
+        }
+
+        if (header.indefinite || header.type == NANOCBOR_TYPE_ARR
+            || header.type == NANOCBOR_TYPE_MAP) {
+            if (level == depth) {
+                return NANOCBOR_ERR_RECURSION;
+            }
+            if (header.type == NANOCBOR_TYPE_MAP && !header.indefinite
+                && header.value > UINT64_MAX / 2) {
+                return NANOCBOR_ERR_OVERFLOW;
+            }
+            nanocbor_stack_entry_t *entry = &stack[level++];
+            entry->flags = header.indefinite ? NANOCBOR_DECODER_FLAG_INDEFINITE
+                                             : 0;
+            entry->remaining = header.type == NANOCBOR_TYPE_MAP
+                ? header.value * 2
+                : header.value;
+            res = _consume(&walker, header.len);
+        }
+        else {
+            res = _advance_header(&walker, &header);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    walker.flags = it->flags;
+    walker.remaining = it->remaining;
+    *it = walker;
+    _item_done(it);
+    return NANOCBOR_OK;
+}
+
+int nanocbor_seg_skip(nanocbor_seg_value_t *it)
+{
+    nanocbor_stack_entry_t stack[NANOCBOR_RECURSION_MAX];
+
+    return nanocbor_seg_skip_stack(it, stack, NANOCBOR_RECURSION_MAX);
+}
@@ -0,0 +1,212 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   Map to struct binding with perfect hash key dispatch
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#include "internal.h"
+
+#define FIELD_NONE SIZE_MAX
+
+uint32_t nanocbor_struct_hash_tstr(uint32_t seed, const uint8_t *key,
+                                   size_t len)
+{
+    return _hash_fnv1a(seed, key, len);
+}
+
+uint32_t nanocbor_struct_hash_int(uint32_t seed, int64_t key)
+{
+    uint8_t buf[sizeof(uint64_t)];
+    uint64_t tmp = (uint64_t)key;
+    /* Big endian two's complement, independent of the host byte order */
+    for (size_t i = sizeof(buf); i > 0; i--) {
+        buf[i - 1] = (uint8_t)tmp;
+        tmp >>= 8U;
+    }
+    return _hash_fnv1a(seed, buf, sizeof(buf));
+}
+
+/* Compare a null terminated name with a text string that is not */
+static bool _name_match(const char *name, const uint8_t *s, size_t len)
+{
+    if (name == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (name[i] == '\0' || (uint8_t)name[i] != s[i]) {
+            return false;
+        }
+    }
+    return name[len] == '\0';
+}
+
+static size_t _lookup_tstr(const nanocbor_struct_t *desc, const uint8_t *s,
+                           size_t len)
+{
+    if (desc->slots) {
+        uint32_t hash = nanocbor_struct_hash_tstr(desc->seed, s, len);
+        size_t idx = desc->slots[hash & desc->slot_mask];
+        if (idx != NANOCBOR_STRUCT_SLOT_EMPTY
+            && _name_match(desc->fields[idx].name, s, len)) {
+            return idx;
+        }
+        return FIELD_NONE;
+    }
+    for (size_t idx = 0; idx < desc->num_fields; idx++) {
+        if (_name_match(desc->fields[idx].name, s, len)) {
+            return idx;
+        }
+    }
+    return FIELD_NONE;
+}
+
+static size_t _lookup_int(const nanocbor_struct_t *desc, int64_t key)
+{
+    if (desc->slots) {
+        uint32_t hash = nanocbor_struct_hash_int(desc->seed, key);
+        size_t idx = desc->slots[hash & desc->slot_mask];
+        if (idx != NANOCBOR_STRUCT_SLOT_EMPTY && desc->fields[idx].name == NULL
+            && desc->fields[idx].key == key) {
+            return idx;
+        }
+        return FIELD_NONE;
+    }
+    for (size_t idx = 0; idx < desc->num_fields; idx++) {
+        if (desc->fields[idx].name == NULL && desc->fields[idx].key == key) {
+            return idx;
+        }
+    }
+    return FIELD_NONE;
+}
+
+/* Consume a map key and look up its field */
+static int _get_field_index(const nanocbor_struct_t *desc,
+                            nanocbor_value_t *map, size_t *idx)
+{
+    nanocbor_header_t header;
+    int res = nanocbor_peek_header(map, &header);
+
+    *idx = FIELD_NONE;
+    if (res < 0) {
+        return res;
+    }
+    if (header.type == NANOCBOR_TYPE_TSTR && !header.indefinite) {
+        const uint8_t *s = NULL;
+        size_t len = 0;
+        res = nanocbor_get_tstr(map, &s, &len);
+        if (res == NANOCBOR_OK) {
+            *idx = _lookup_tstr(desc, s, len);
+        }
+        return res;
+    }
+    if (header.type == NANOCBOR_TYPE_UINT || header.type == NANOCBOR_TYPE_NINT) {
+        res = nanocbor_advance_header(map, &header);
+        if (res == NANOCBOR_OK && header.value <= INT64_MAX) {
+            int64_t key = header.type == NANOCBOR_TYPE_UINT
+                ? (int64_t)header.value
+                : -1 - (int64_t)header.value;
+            *idx = _lookup_int(desc, key);
+        }
+        return res;
+    }
+    /* Keys of other types never match a field */
+    return nanocbor_skip(map);
+}
+
+static int _get_field(nanocbor_value_t *map, const nanocbor_field_t *field,
+                      void *out)
+{
+    void *member = (uint8_t *)out + field->offset;
+
+    switch (field->type) {
+    case NANOCBOR_FIELD_UINT8:
+        return nanocbor_get_uint8(map, member);
+    case NANOCBOR_FIELD_UINT16:
+        return nanocbor_get_uint16(map, member);
+    case NANOCBOR_FIELD_UINT32:
+        return nanocbor_get_uint32(map, member);
+    case NANOCBOR_FIELD_UINT64:
+        return nanocbor_get_uint64(map, member);
+    case NANOCBOR_FIELD_INT8:
+        return nanocbor_get_int8(map, member);
+    case NANOCBOR_FIELD_INT16:
+        return nanocbor_get_int16(map, member);
+    case NANOCBOR_FIELD_INT32:
+        return nanocbor_get_int32(map, member);
+    case NANOCBOR_FIELD_INT64:
+        return nanocbor_get_int64(map, member);
+    case NANOCBOR_FIELD_BOOL:
+        return nanocbor_get_bool(map, member);
+    case NANOCBOR_FIELD_FLOAT:
+        return nanocbor_get_float(map, member);
+    case NANOCBOR_FIELD_DOUBLE:
+        return nanocbor_get_double(map, member);
+    case NANOCBOR_FIELD_BSTR: {
+        nanocbor_str_t *str = member;
+        return nanocbor_get_bstr(map, &str->buf, &str->len);
+    }
+    case NANOCBOR_FIELD_TSTR: {
+        nanocbor_str_t *str = member;
+        return nanocbor_get_tstr(map, &str->buf, &str->len);
+    }
+    case NANOCBOR_FIELD_VALUE:
+        *(nanocbor_value_t *)member = *map;
+        return nanocbor_skip(map);
+    default:
+        return NANOCBOR_ERR_INVALID_TYPE;
+    }
+}
+
+int nanocbor_get_struct(nanocbor_value_t *it, const nanocbor_struct_t *desc,
+                        void *out)
+{
+    nanocbor_value_t map;
+    uint64_t required = 0;
+    uint64_t seen = 0;
+
+    if (desc->num_fields > NANOCBOR_STRUCT_FIELDS_MAX) {
+        return NANOCBOR_ERR_OVERFLOW;
+    }
+    for (size_t idx = 0; idx < desc->num_fields; idx++) {
+        if (desc->fields[idx].flags & NANOCBOR_FIELD_FLAG_REQUIRED) {
+            required |= 1ULL << idx;
+        }
+    }
+
+    int res = nanocbor_enter_map(it, &map);
+    while (res >= 0 && !nanocbor_at_end(&map)) {
+        size_t idx = FIELD_NONE;
+        res = _get_field_index(desc, &map, &idx);
+        if (res < 0) {
+            break;
+        }
+        if (idx != FIELD_NONE && !(seen & (1ULL << idx))) {
+            seen |= 1ULL << idx;
+            res = _get_field(&map, &desc->fields[idx], out);
+        }
+        else {
+            res = nanocbor_skip(&map);
+        }
+    }
+    if (res >= 0 && (seen & required) != required) {
+        res = NANOCBOR_NOT_FOUND;
+    }
+    if (res < 0) {
+        return res;
+    }
+    nanocbor_leave_container(it, &map);
+    return NANOCBOR_OK;
+}
@@ -0,0 +1,305 @@
+/*
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/**
+ * @ingroup nanocbor
+ * @{
+ * @file
+ * @brief   UTF-8 validation for text strings
+ *
+ * The vectorized kernels implement the lookup algorithm by Keiser and Lemire,
+ * "Validating UTF-8 In Less Than One Instruction Per Byte". Every pair of
+ * consecutive bytes is classified with three 16 entry tables, the remaining
+ * checks for the third and fourth byte of a sequence only need saturating
+ * subtractions.
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nanocbor/config.h"
+#include "nanocbor/nanocbor.h"
+
+#if NANOCBOR_USE_SIMD && defined(__x86_64__) && defined(__GNUC__)
+#define UTF8_X86_DISPATCH 1
+#include <immintrin.h>
+#else
+#define UTF8_X86_DISPATCH 0
+#endif
+
+/* Strings shorter than a vector are checked with the scalar implementation */
+#define UTF8_SIMD_MIN_LEN (16U)
+
+#define ASCII_MASK (0x8080808080808080ULL)
+
+static int _check_scalar(const uint8_t *buf, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len) {
+        uint64_t word = 0;
+        if (len - i >= sizeof(word)) {
+            memcpy(&word, buf + i, sizeof(word));
+            if (!(word & ASCII_MASK)) {
+                i += sizeof(word);
+                continue;
+            }
+        }
+        uint8_t lead = buf[i];
+        if (lead < 0x80U) {
+            i++;
+            continue;
+        }
+        /* Number of continuation bytes and the range of the first one, which
+         * excludes overlong encodings, surrogates and values above U+10FFFF */
+        size_t num = 0;
+        uint8_t low = 0x80U;
+        uint8_t high = 0xBFU;
+        if (lead >= 0xC2U && lead <= 0xDFU) {
+            num = 1;
+        }
+        else if (lead >= 0xE0U && lead <= 0xEFU) {
+            num = 2;
+            low = lead == 0xE0U ? 0xA0U : low;
+            high = lead == 0xEDU ? 0x9FU : high;
+        }
+        else if (lead >= 0xF0U && lead <= 0xF4U) {
+            num = 3;
+            low = lead == 0xF0U ? 0x90U : low;
+            high = lead == 0xF4U ? 0x8FU : high;
+        }
+        else {
+            return NANOCBOR_ERR_INVALID_UTF8;
+        }
+        if (len - i - 1 < num || buf[i + 1] < low || buf[i + 1] > high) {
+            return NANOCBOR_ERR_INVALID_UTF8;
+        }
+        for (size_t k = 2; k <= num; k++) {
+            if ((buf[i + k] & 0xC0U) != 0x80U) {
+                return NANOCBOR_ERR_INVALID_UTF8;
+            }
+        }
+        i += num + 1;
+    }
+    return NANOCBOR_OK;
+}
+
+#if UTF8_X86_DISPATCH
+
+/* Error classes of a pair of consecutive bytes */
+#define TOO_SHORT (1U << 0U) /* Lead byte followed by a non-continuation */
+#define TOO_LONG (1U << 1U) /* ASCII followed by a continuation */
+#define OVERLONG_3 (1U << 2U) /* 11100000 100_____ */
+#define TOO_LARGE (1U << 3U) /* 11110100 1001____ and above */
+#define SURROGATE (1U << 4U) /* 11101101 101_____ */
+#define OVERLONG_2 (1U << 5U) /* 1100000_ 10______ */
+#define TOO_LARGE_1000 (1U << 6U) /* 11110101 1000____ and above */
+#define OVERLONG_4 (1U << 6U) /* 11110000 1000____ */
+#define TWO_CONTS (1U << 7U) /* Continuation followed by a continuation */
+#define CARRY (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+/* Indexed by the high nibble of the first byte */
+static const uint8_t _byte_1_high[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+/* Indexed by the low nibble of the first byte */
+static const uint8_t _byte_1_low[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+/* Indexed by the high nibble of the second byte */
+static const uint8_t _byte_2_high[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000
+        | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+/* A block ending in a lead byte is continued in the next block */
+static const uint8_t _incomplete_max[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+__attribute__((target("ssse3"))) static __m128i
+_block_ssse3(__m128i input, __m128i prev)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)_byte_1_high),
+                             _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)_byte_1_low),
+                             _mm_and_si128(prev1, nibble))),
+        _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)_byte_2_high),
+                         _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+    /* Third and fourth bytes of a sequence must be continuations */
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14),
+                                  _mm_set1_epi8(0xE0 - 0x80));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13),
+                                   _mm_set1_epi8(0xF0 - 0x80));
+    __m128i must_cont = _mm_and_si128(_mm_or_si128(third, fourth),
+                                      _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must_cont, special);
+}
+
+__attribute__((target("ssse3"))) static int _check_ssse3(const uint8_t *buf,
+                                                         size_t len)
+{
+    const __m128i max
+        = _mm_loadu_si128((const __m128i *)(_incomplete_max + 16));
+    __m128i prev = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+
+    for (size_t i = 0; i < len; i += sizeof(__m128i)) {
+        __m128i input;
+        if (len - i >= sizeof(__m128i)) {
+            input = _mm_loadu_si128((const __m128i *)(buf + i));
+        }
+        else {
+            /* Pad the tail with ASCII */
+            uint8_t tail[sizeof(__m128i)] = { 0 };
+            memcpy(tail, buf + i, len - i);
+            input = _mm_loadu_si128((const __m128i *)tail);
+        }
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, incomplete);
+        }
+        else {
+            error = _mm_or_si128(error, _block_ssse3(input, prev));
+            incomplete = _mm_subs_epu8(input, max);
+        }
+        prev = input;
+    }
+    error = _mm_or_si128(error, incomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128()))
+            == 0xFFFF
+        ? NANOCBOR_OK
+        : NANOCBOR_ERR_INVALID_UTF8;
+}
+
+__attribute__((target("avx2"))) static __m256i _block_avx2(__m256i input,
+                                                           __m256i prev)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    /* Last bytes of the previous block in the low lane */
+    __m256i shifted = _mm256_permute2x128_si256(prev, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(
+            _mm256_shuffle_epi8(
+                _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128((const __m128i *)_byte_1_high)),
+                _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+            _mm256_shuffle_epi8(
+                _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128((const __m128i *)_byte_1_low)),
+                _mm256_and_si256(prev1, nibble))),
+        _mm256_shuffle_epi8(
+            _mm256_broadcastsi128_si256(
+                _mm_loadu_si128((const __m128i *)_byte_2_high)),
+            _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+    __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 14),
+                                     _mm256_set1_epi8(0xE0 - 0x80));
+    __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(input, shifted, 13),
+                                      _mm256_set1_epi8(0xF0 - 0x80));
+    __m256i must_cont = _mm256_and_si256(_mm256_or_si256(third, fourth),
+                                         _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must_cont, special);
+}
+
+__attribute__((target("avx2"))) static int _check_avx2(const uint8_t *buf,
+                                                       size_t len)
+{
+    const __m256i max = _mm256_loadu_si256((const __m256i *)_incomplete_max);
+    __m256i prev = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < len; i += sizeof(__m256i)) {
+        __m256i input;
+        if (len - i >= sizeof(__m256i)) {
+            input = _mm256_loadu_si256((const __m256i *)(buf + i));
+        }
+        else {
+            uint8_t tail[sizeof(__m256i)] = { 0 };
+            memcpy(tail, buf + i, len - i);
+            input = _mm256_loadu_si256((const __m256i *)tail);
+        }
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, incomplete);
+        }
+        else {
+            error = _mm256_or_si256(error, _block_avx2(input, prev));
+            incomplete = _mm256_subs_epu8(input, max);
+        }
+        prev = input;
+    }
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error) ? NANOCBOR_OK
+                                            : NANOCBOR_ERR_INVALID_UTF8;
+}
+
+static int _check_dispatch(const uint8_t *buf, size_t len);
+
+/* Resolved on first use, racing threads store the same value */
+static int (*_check_simd)(const uint8_t *buf, size_t len) = _check_dispatch;
+
+static int _check_dispatch(const uint8_t *buf, size_t len)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        _check_simd = _check_avx2;
+    }
+    else if (__builtin_cpu_supports("ssse3")) {
+        _check_simd = _check_ssse3;
+    }
+    else {
+        _check_simd = _check_scalar;
+    }
+    return _check_simd(buf, len);
+}
+#endif
+
+int nanocbor_check_utf8(const uint8_t *buf, size_t len)
+{
+#if UTF8_X86_DISPATCH
+    if (len >= UTF8_SIMD_MIN_LEN) {
+        return _check_simd(buf, len);
+    }
+#endif
+    return _check_scalar(buf, len);
+}
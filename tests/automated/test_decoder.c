@@ -2,12 +2,29 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include "nanocbor/config.h"
 #include "nanocbor/nanocbor.h"
 #include "test.h"
 #include <CUnit/CUnit.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 /* NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers) */
 
+struct test_struct {
+    uint32_t id;
+    nanocbor_str_t name;
+    bool valid;
+    nanocbor_value_t payload;
+    float temp;
+    int16_t offset;
+    uint64_t total;
+};
+
+/* Generated from test_struct.json */
+#include "test_struct.h"
+
 static void test_decode_indefinite(void)
 {
     /* Test vector, 3 integers in an indefinite array */
@@ -218,6 +235,154 @@ static void test_decode_basic(void)
     CU_ASSERT_EQUAL(mantissa, 27315);
 }
 
+static void test_decode_float(void)
+{
+    /* [1.5 (half), 100000.0 (single), 1.1 (double), -0.0 (half), true] */
+    static const uint8_t floats[]
+        = { 0x85, 0xf9, 0x3e, 0x00, 0xfa, 0x47, 0xc3, 0x50, 0x00, 0xfb,
+            0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a, 0xf9, 0x80,
+            0x00, 0xf5 };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    float fvalue = 0;
+    double dvalue = 0;
+
+    nanocbor_decoder_init(&val, floats, sizeof(floats));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_float(&arr, &fvalue), 3);
+    CU_ASSERT_EQUAL(fvalue, 1.5);
+    CU_ASSERT_EQUAL(nanocbor_get_double(&arr, &dvalue), 5);
+    CU_ASSERT_EQUAL(dvalue, 100000.0);
+    CU_ASSERT_EQUAL(nanocbor_get_float(&arr, &fvalue), NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(nanocbor_get_double(&arr, &dvalue), 9);
+    CU_ASSERT_EQUAL(dvalue, 1.1);
+    CU_ASSERT_EQUAL(nanocbor_get_double(&arr, &dvalue), 3);
+    CU_ASSERT_EQUAL(dvalue, 0.0);
+    CU_ASSERT(signbit(dvalue));
+    CU_ASSERT_EQUAL(nanocbor_get_double(&arr, &dvalue),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_get_float(&arr, &fvalue),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+}
+
+static void test_decode_header(void)
+{
+    /* [_ 500, "ab", 6(-1), 0xf8 0x20, 0x1c] */
+    static const uint8_t items[] = { 0x9f, 0x19, 0x01, 0xf4, 0x62, 0x61, 0x62,
+                                     0xc6, 0x20, 0xf8, 0x20, 0xff, 0x1c };
+
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_header_t header;
+
+    nanocbor_decoder_init(&val, items, sizeof(items));
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&val, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_ARR);
+    CU_ASSERT_EQUAL(header.indefinite, true);
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&val, &header),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_UINT);
+    CU_ASSERT_EQUAL(header.value, 500);
+    CU_ASSERT_EQUAL(header.len, 3);
+    CU_ASSERT_EQUAL(header.indefinite, false);
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&arr, &header), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_TSTR);
+    CU_ASSERT_EQUAL(header.value, 2);
+    CU_ASSERT_EQUAL(arr.cur[header.len], 'a');
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&arr, &header), NANOCBOR_OK);
+
+    /* Tag header is consumed separately from the tagged item */
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_TAG);
+    CU_ASSERT_EQUAL(header.value, 6);
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_NINT);
+    CU_ASSERT_EQUAL(header.value, 0);
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&arr, &header), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(header.type, NANOCBOR_TYPE_FLOAT);
+    CU_ASSERT_EQUAL(header.value, 32);
+    CU_ASSERT_EQUAL(header.len, 2);
+    CU_ASSERT_EQUAL(nanocbor_advance_header(&arr, &header), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&arr, &header), NANOCBOR_ERR_END);
+    nanocbor_leave_container(&val, &arr);
+
+    /* Reserved additional information */
+    CU_ASSERT_EQUAL(nanocbor_peek_header(&val, &header),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void test_decode_bulk_array(void)
+{
+    uint8_t buf[128];
+    uint32_t values[64];
+    int64_t ivalues[8];
+    float fvalues[4];
+    size_t num = 0;
+    nanocbor_value_t val;
+
+    /* [0, 1, ..., 23, 0, 1, ..., 23, 1000, 5] */
+    buf[0] = 0x98;
+    buf[1] = 50;
+    for (size_t i = 0; i < 48; i++) {
+        buf[2 + i] = (uint8_t)(i % 24);
+    }
+    buf[50] = 0x19;
+    buf[51] = 0x03;
+    buf[52] = 0xe8;
+    buf[53] = 0x05;
+
+    nanocbor_decoder_init(&val, buf, 54);
+    CU_ASSERT_EQUAL(nanocbor_get_uint32_array(&val, values, 64, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 50);
+    CU_ASSERT_EQUAL(values[0], 0);
+    CU_ASSERT_EQUAL(values[23], 23);
+    CU_ASSERT_EQUAL(values[47], 23);
+    CU_ASSERT_EQUAL(values[48], 1000);
+    CU_ASSERT_EQUAL(values[49], 5);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    /* Not enough room, nothing consumed */
+    nanocbor_decoder_init(&val, buf, 54);
+    CU_ASSERT_EQUAL(nanocbor_get_uint32_array(&val, values, 49, &num),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(num, 49);
+    CU_ASSERT_EQUAL(val.cur, buf);
+
+    /* [_ 1, -1, 2, "a"] reports the partial result */
+    static const uint8_t mixed[] = { 0x9f, 0x01, 0x20, 0x02, 0x61, 0x61, 0xff };
+    nanocbor_decoder_init(&val, mixed, sizeof(mixed));
+    CU_ASSERT_EQUAL(nanocbor_get_int64_array(&val, ivalues, 8, &num),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(num, 3);
+    CU_ASSERT_EQUAL(ivalues[0], 1);
+    CU_ASSERT_EQUAL(ivalues[1], -1);
+    CU_ASSERT_EQUAL(ivalues[2], 2);
+
+    /* [1.5 (half), 100000.0 (single)] */
+    static const uint8_t floats[]
+        = { 0x82, 0xf9, 0x3e, 0x00, 0xfa, 0x47, 0xc3, 0x50, 0x00 };
+    nanocbor_decoder_init(&val, floats, sizeof(floats));
+    CU_ASSERT_EQUAL(nanocbor_get_float_array(&val, fvalues, 4, &num),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(num, 2);
+    CU_ASSERT_EQUAL(fvalues[0], 1.5);
+    CU_ASSERT_EQUAL(fvalues[1], 100000.0);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+}
+
 static void _decode_skip_simple(const uint8_t *test_case, size_t test_case_len)
 {
     nanocbor_value_t decoder;
@@ -248,6 +413,987 @@ static void test_decode_skip(void)
     _decode_skip_simple(test_simple, sizeof(test_simple));
 }
 
+static void test_decode_skip_stack(void)
+{
+    /* [1(2), [_ 3, 4], 5], tags are skipped together with their content */
+    static const uint8_t tagged[] = { 0x83, 0xc1, 0x02, 0x9f, 0x03,
+                                      0x04, 0xff, 0x05 };
+    uint8_t nested[200];
+    nanocbor_stack_entry_t stack[100];
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, tagged, sizeof(tagged));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 5);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+
+    /* 100 nested arrays, the innermost one containing a single integer */
+    memset(nested, 0x81, 100);
+    memset(nested + 100, 0x00, 1);
+    nanocbor_decoder_init(&val, nested, 101);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(nanocbor_skip_stack(&val, stack, 99),
+                    NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(nanocbor_skip_stack(&val, stack, 100), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    /* Truncated nested input */
+    nanocbor_decoder_init(&val, nested, 100);
+    CU_ASSERT_EQUAL(nanocbor_skip_stack(&val, stack, 100), NANOCBOR_ERR_END);
+}
+
+static void test_decode_stream(void)
+{
+    /* [1, "abc", {_ "k": 2}] */
+    static const uint8_t doc[] = { 0x83, 0x01, 0x63, 0x61, 0x62, 0x63,
+                                   0xbf, 0x61, 0x6b, 0x02, 0xff };
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_value_t map;
+    nanocbor_value_t key;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+    uint32_t tmp = 0;
+
+    /* Feed the input byte by byte, retrying each step */
+    nanocbor_decoder_stream_init(&val, doc, 0);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), false);
+    while (nanocbor_enter_array(&val, &arr) == NANOCBOR_ERR_NEED_MORE) {
+        nanocbor_decoder_stream_feed(&val, 1);
+    }
+    while (nanocbor_get_uint32(&arr, &tmp) == NANOCBOR_ERR_NEED_MORE) {
+        nanocbor_decoder_stream_feed(&arr, 1);
+    }
+    CU_ASSERT_EQUAL(tmp, 1);
+    while (nanocbor_get_tstr(&arr, &str, &len) == NANOCBOR_ERR_NEED_MORE) {
+        CU_ASSERT_EQUAL(arr.cur, doc + 2);
+        nanocbor_decoder_stream_feed(&arr, 1);
+    }
+    CU_ASSERT_EQUAL(len, 3);
+    CU_ASSERT_EQUAL(memcmp(str, "abc", len), 0);
+    while (nanocbor_enter_map(&arr, &map) == NANOCBOR_ERR_NEED_MORE) {
+        nanocbor_decoder_stream_feed(&arr, 1);
+    }
+    while (nanocbor_get_key_tstr(&map, "k", &key) == NANOCBOR_ERR_NEED_MORE) {
+        nanocbor_decoder_stream_feed(&map, 1);
+    }
+    while (nanocbor_get_uint32(&key, &tmp) == NANOCBOR_ERR_NEED_MORE) {
+        nanocbor_decoder_stream_feed(&map, 1);
+        nanocbor_decoder_stream_sync(&key, &map);
+    }
+    CU_ASSERT_EQUAL(tmp, 2);
+    CU_ASSERT_EQUAL(nanocbor_skip(&map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&map), false);
+    CU_ASSERT_EQUAL(nanocbor_get_type(&map), NANOCBOR_ERR_NEED_MORE);
+    nanocbor_decoder_stream_feed(&map, 1);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&map), true);
+    nanocbor_leave_container(&arr, &map);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+    nanocbor_leave_container(&val, &arr);
+    CU_ASSERT_EQUAL(val.end, doc + sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_get_type(&val), NANOCBOR_ERR_NEED_MORE);
+    nanocbor_decoder_stream_finish(&val);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    /* Decimal fractions are retried from the tag */
+    static const uint8_t decimal_frac[] = { 0xc4, 0x82, 0x21, 0x19, 0x6a, 0xb3 };
+    int32_t exponent = 0;
+    int32_t mantissa = 0;
+    int res = NANOCBOR_OK;
+    nanocbor_decoder_stream_init(&val, decimal_frac, 1);
+    while ((res = nanocbor_get_decimal_frac(&val, &exponent, &mantissa))
+           == NANOCBOR_ERR_NEED_MORE) {
+        CU_ASSERT_EQUAL(val.cur, decimal_frac);
+        nanocbor_decoder_stream_feed(&val, 1);
+    }
+    CU_ASSERT_EQUAL(res, NANOCBOR_OK);
+    CU_ASSERT_EQUAL(exponent, -2);
+    CU_ASSERT_EQUAL(mantissa, 27315);
+    CU_ASSERT_EQUAL(val.cur, decimal_frac + sizeof(decimal_frac));
+
+    /* Skipping resumes from the start of the item */
+    nanocbor_decoder_stream_init(&val, doc, 7);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_NEED_MORE);
+    CU_ASSERT_EQUAL(val.cur, doc);
+    nanocbor_decoder_stream_feed(&val, sizeof(doc) - 7);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(val.cur, doc + sizeof(doc));
+
+    /* Truncated input after the end of the stream */
+    nanocbor_decoder_stream_init(&val, doc, 4);
+    nanocbor_decoder_stream_finish(&val);
+    CU_ASSERT_EQUAL(nanocbor_skip(&val), NANOCBOR_ERR_END);
+}
+
+static void test_decode_str_chunks(void)
+{
+    /* [(_ h'0102', h'030405'), "ab", (_ "c", 1)] */
+    static const uint8_t doc[] = { 0x83, 0x5f, 0x42, 0x01, 0x02, 0x43, 0x03,
+                                   0x04, 0x05, 0xff, 0x62, 0x61, 0x62, 0x7f,
+                                   0x61, 0x63, 0x01, 0xff };
+    static const uint8_t expected[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_value_t chunks;
+    const uint8_t *buf = NULL;
+    size_t len = 0;
+    uint8_t copy[5];
+
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+
+    /* Chunks point into the decoded buffer */
+    CU_ASSERT_EQUAL(nanocbor_enter_tstr_chunks(&arr, &chunks),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_enter_bstr_chunks(&arr, &chunks), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &buf, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(buf, doc + 3);
+    CU_ASSERT_EQUAL(len, 2);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &buf, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(buf, doc + 6);
+    CU_ASSERT_EQUAL(len, 3);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&chunks), true);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &buf, &len),
+                    NANOCBOR_ERR_END);
+    nanocbor_leave_container(&arr, &chunks);
+
+    /* A definite length string is a single chunk */
+    CU_ASSERT_EQUAL(nanocbor_enter_tstr_chunks(&arr, &chunks), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &buf, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 2);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&chunks), true);
+    nanocbor_leave_container(&arr, &chunks);
+
+    /* Chunks must have the type of the string */
+    CU_ASSERT_EQUAL(nanocbor_enter_tstr_chunks(&arr, &chunks), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &buf, &len), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_next_chunk(&chunks, &buf, &len) < 0);
+
+    /* Concatenation */
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    len = sizeof(copy) - 1;
+    CU_ASSERT_EQUAL(nanocbor_get_bstr_concat(&arr, copy, &len),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(arr.cur, doc + 1);
+    len = sizeof(copy);
+    CU_ASSERT_EQUAL(nanocbor_get_bstr_concat(&arr, copy, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, sizeof(expected));
+    CU_ASSERT_EQUAL(memcmp(copy, expected, sizeof(expected)), 0);
+    len = sizeof(copy);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr_concat(&arr, copy, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 2);
+    CU_ASSERT_EQUAL(memcmp(copy, "ab", 2), 0);
+
+    /* Indefinite length strings are skipped as a whole */
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(arr.cur, doc + 10);
+}
+
+static void test_decode_keys(void)
+{
+    /* {"a": 1, 2: 3, "bc": 4, "a": 5, "d": 6} */
+    static const uint8_t doc[] = { 0xa5, 0x61, 0x61, 0x01, 0x02, 0x03, 0x62,
+                                   0x62, 0x63, 0x04, 0x61, 0x61, 0x05, 0x61,
+                                   0x64, 0x06 };
+    static const char *const keys[] = { "d", "x", "bc", "a", "" };
+    nanocbor_value_t out[5];
+    nanocbor_value_t val;
+    nanocbor_value_t map;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_keys_tstr(&map, keys, 5, out), 3);
+    CU_ASSERT(nanocbor_get_uint32(&out[0], &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 6);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&out[1]), true);
+    CU_ASSERT(nanocbor_get_uint32(&out[2], &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 4);
+    /* The first occurrence of a key is returned */
+    CU_ASSERT(nanocbor_get_uint32(&out[3], &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 1);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&out[4]), true);
+    CU_ASSERT_EQUAL(nanocbor_get_type(&out[4]), NANOCBOR_ERR_END);
+    /* The map itself is not advanced */
+    CU_ASSERT_EQUAL(map.cur, doc + 1);
+
+    /* Truncated map */
+    nanocbor_decoder_init(&val, doc, sizeof(doc) - 1);
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_keys_tstr(&map, keys, 5, out) < 0);
+}
+
+static void test_decode_key_int(void)
+{
+    /* {1: 2, 4: 5, 24: 6, -1: 7, -300: 8, "a": 9}, deterministic */
+    static const uint8_t doc[] = { 0xa6, 0x01, 0x02, 0x04, 0x05, 0x18, 0x18,
+                                   0x06, 0x20, 0x07, 0x39, 0x01, 0x2b, 0x08,
+                                   0x61, 0x61, 0x09 };
+    /* The same map truncated in the third key */
+    static const uint8_t truncated[] = { 0xa6, 0x01, 0x02, 0x04, 0x05, 0x18 };
+    nanocbor_value_t val;
+    nanocbor_value_t map;
+    nanocbor_value_t value;
+    uint32_t tmp = 0;
+
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_key_uint(&map, 24, &value), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&value, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 6);
+    CU_ASSERT_EQUAL(nanocbor_get_key_int(&map, -300, &value), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&value, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 8);
+    CU_ASSERT_EQUAL(nanocbor_get_key_int(&map, 1, &value), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&value, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 2);
+    CU_ASSERT_EQUAL(nanocbor_get_key_int(&map, -2, &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_get_key_uint(&map, 3, &value),
+                    NANOCBOR_NOT_FOUND);
+
+    /* Sorted maps are only decoded up to the position of the key */
+    nanocbor_decoder_init(&val, truncated, sizeof(truncated));
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_key_uint(&map, 3, &value) < 0);
+    nanocbor_decoder_set_sorted(&val);
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_key_uint(&map, 3, &value),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(nanocbor_get_key_uint(&map, 4, &value), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_key_uint(&map, 24, &value) < 0);
+}
+
+static void test_decode_struct(void)
+{
+    /* {1: 1.5, "name": "ab", 7: 0, "payload": [2], -3: -4, "id": 5, 300: 6,
+     *  "id": 8} */
+    static const uint8_t doc[]
+        = { 0xa8, 0x01, 0xf9, 0x3e, 0x00, 0x64, 0x6e, 0x61, 0x6d, 0x65,
+            0x62, 0x61, 0x62, 0x07, 0x00, 0x67, 0x70, 0x61, 0x79, 0x6c,
+            0x6f, 0x61, 0x64, 0x81, 0x02, 0x22, 0x23, 0x62, 0x69, 0x64,
+            0x05, 0x19, 0x01, 0x2c, 0x06, 0x62, 0x69, 0x64, 0x08 };
+    /* {"name": "ab"} */
+    static const uint8_t missing[] = { 0xa1, 0x64, 0x6e, 0x61, 0x6d, 0x65,
+                                       0x62, 0x61, 0x62 };
+    /* {"id": "ab"} */
+    static const uint8_t wrong_type[] = { 0xa1, 0x62, 0x69, 0x64,
+                                          0x62, 0x61, 0x62 };
+    nanocbor_struct_t linear = test_struct_desc;
+    struct test_struct out;
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    uint32_t tmp = 0;
+
+    linear.slots = NULL;
+    for (unsigned i = 0; i < 2; i++) {
+        const nanocbor_struct_t *desc = i ? &linear : &test_struct_desc;
+        memset(&out, 0, sizeof(out));
+        nanocbor_decoder_init(&val, doc, sizeof(doc));
+        CU_ASSERT_EQUAL(nanocbor_get_struct(&val, desc, &out), NANOCBOR_OK);
+        CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+        /* The first occurrence of a key is used */
+        CU_ASSERT_EQUAL(out.id, 5);
+        CU_ASSERT_EQUAL(out.name.len, 2);
+        CU_ASSERT_EQUAL(memcmp(out.name.buf, "ab", 2), 0);
+        CU_ASSERT_EQUAL(out.valid, false);
+        CU_ASSERT_EQUAL(out.temp, 1.5);
+        CU_ASSERT_EQUAL(out.offset, -4);
+        CU_ASSERT_EQUAL(out.total, 6);
+        CU_ASSERT_EQUAL(nanocbor_enter_array(&out.payload, &arr), NANOCBOR_OK);
+        CU_ASSERT(nanocbor_get_uint32(&arr, &tmp) > 0);
+        CU_ASSERT_EQUAL(tmp, 2);
+    }
+
+    /* A required field is missing */
+    nanocbor_decoder_init(&val, missing, sizeof(missing));
+    CU_ASSERT_EQUAL(nanocbor_get_struct(&val, &test_struct_desc, &out),
+                    NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(val.cur, missing);
+
+    /* A field with the wrong type */
+    nanocbor_decoder_init(&val, wrong_type, sizeof(wrong_type));
+    CU_ASSERT_EQUAL(nanocbor_get_struct(&val, &test_struct_desc, &out),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_get_struct(&val, &linear, &out),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static char _events[256];
+
+static int _event_log(const char *event)
+{
+    size_t len = strlen(_events);
+    snprintf(_events + len, sizeof(_events) - len, "%s ", event);
+    return 0;
+}
+
+static int _event_uint(void *ctx, uint64_t value)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "%u", (unsigned)value);
+    /* Abort on a magic value */
+    return value == 99 ? -42 : _event_log(buf);
+}
+
+static int _event_nint(void *ctx, uint64_t value)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "-%u", (unsigned)value + 1);
+    return _event_log(buf);
+}
+
+static int _event_str(void *ctx, const uint8_t *str, size_t len)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "'%.*s'", (int)len, (const char *)str);
+    return _event_log(buf);
+}
+
+static int _event_start(void *ctx, uint64_t len, bool indefinite)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "%s%u", indefinite ? "(_" : "(", (unsigned)len);
+    return _event_log(buf);
+}
+
+static int _event_start_chunks(void *ctx, uint8_t type)
+{
+    (void)ctx;
+    return _event_log(type == NANOCBOR_TYPE_TSTR ? "t(_" : "b(_");
+}
+
+static int _event_end(void *ctx)
+{
+    (void)ctx;
+    return _event_log(")");
+}
+
+static int _event_tag(void *ctx, uint64_t tag)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "#%u", (unsigned)tag);
+    return _event_log(buf);
+}
+
+static int _event_float(void *ctx, double value)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "%g", value);
+    return _event_log(buf);
+}
+
+static int _event_simple(void *ctx, uint8_t value)
+{
+    char buf[32];
+    (void)ctx;
+    snprintf(buf, sizeof(buf), "s%u", value);
+    return _event_log(buf);
+}
+
+static void test_decode_events(void)
+{
+    /* [1, -2, {_ "a": h'62'}, 2(1.5), [], (_ "c", "d"), true], 3 */
+    static const uint8_t doc[]
+        = { 0x87, 0x01, 0x21, 0xbf, 0x61, 0x61, 0x41, 0x62, 0xff, 0xc2,
+            0xf9, 0x3e, 0x00, 0x80, 0x7f, 0x61, 0x63, 0x61, 0x64, 0xff,
+            0xf5, 0x03 };
+    static const uint8_t abort[] = { 0x82, 0x18, 0x63, 0x01 };
+    static const uint8_t bad_chunk[] = { 0x5f, 0x61, 0x61, 0xff };
+    static const uint8_t dangling_tag[] = { 0x9f, 0xc2, 0xff };
+    static const uint8_t odd_map[] = { 0xbf, 0x01, 0xff };
+    static const nanocbor_callbacks_t cb = {
+        .on_uint = _event_uint,
+        .on_nint = _event_nint,
+        .on_bstr = _event_str,
+        .on_tstr = _event_str,
+        .on_start_array = _event_start,
+        .on_end_array = _event_end,
+        .on_start_map = _event_start,
+        .on_end_map = _event_end,
+        .on_start_chunks = _event_start_chunks,
+        .on_end_chunks = _event_end,
+        .on_tag = _event_tag,
+        .on_float = _event_float,
+        .on_simple = _event_simple,
+    };
+    static const nanocbor_callbacks_t none = { 0 };
+    nanocbor_stack_entry_t stack[2];
+
+    _events[0] = '\0';
+    CU_ASSERT_EQUAL(nanocbor_parse_events(doc, sizeof(doc), &cb, NULL),
+                    NANOCBOR_OK);
+    CU_ASSERT_STRING_EQUAL(_events, "(7 1 -2 (_0 'a' 'b' ) #2 1.5 (0 ) t(_ "
+                                    "'c' 'd' ) s21 ) 3 ");
+    CU_ASSERT_EQUAL(nanocbor_parse_events(doc, sizeof(doc), &none, NULL),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_parse_events_stack(doc, sizeof(doc), &none, NULL,
+                                                stack, 1),
+                    NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(nanocbor_parse_events_stack(doc, sizeof(doc), &none, NULL,
+                                                stack, 2),
+                    NANOCBOR_OK);
+
+    /* Callbacks abort parsing */
+    CU_ASSERT_EQUAL(nanocbor_parse_events(abort, sizeof(abort), &cb, NULL),
+                    -42);
+
+    /* Malformed input */
+    CU_ASSERT_EQUAL(nanocbor_parse_events(doc, sizeof(doc) - 2, &none, NULL),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(
+        nanocbor_parse_events(bad_chunk, sizeof(bad_chunk), &none, NULL),
+        NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT(nanocbor_parse_events(dangling_tag, sizeof(dangling_tag), &none,
+                                    NULL)
+              < 0);
+    CU_ASSERT_EQUAL(nanocbor_parse_events(odd_map, sizeof(odd_map), &none,
+                                          NULL),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void test_decode_validate(void)
+{
+    static const struct {
+        const char *hex;
+        int res;
+        size_t offset;
+    } cases[] = {
+        /* Well-formed */
+        { "", NANOCBOR_OK, 0 },
+        { "83010203", NANOCBOR_OK, 4 },
+        { "a2616101c2410280", NANOCBOR_OK, 8 },
+        { "9f5f4101ff7f6161ffbfffff", NANOCBOR_OK, 12 },
+        { "f820f4fb3ff0000000000000", NANOCBOR_OK, 12 },
+        { "0102", NANOCBOR_OK, 2 },
+        /* Truncated */
+        { "19", NANOCBOR_ERR_END, 0 },
+        { "8201", NANOCBOR_ERR_END, 0 },
+        { "6461", NANOCBOR_ERR_END, 0 },
+        { "9f01", NANOCBOR_ERR_END, 2 },
+        { "81c1", NANOCBOR_ERR_END, 2 },
+        /* Reserved additional information */
+        { "811c", NANOCBOR_ERR_INVALID_TYPE, 1 },
+        { "fe", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        /* Indefinite length on integers and tags */
+        { "1f", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        { "df01", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        /* Misplaced break markers */
+        { "ff", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        { "8101ff", NANOCBOR_ERR_INVALID_TYPE, 2 },
+        { "9fc1ff", NANOCBOR_ERR_INVALID_TYPE, 2 },
+        { "bf01ff", NANOCBOR_ERR_INVALID_TYPE, 2 },
+        { "bf010203ff", NANOCBOR_ERR_INVALID_TYPE, 4 },
+        /* Two byte simple values below 32 */
+        { "f820", NANOCBOR_OK, 2 },
+        { "f814", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        /* Chunks of the wrong type */
+        { "5f6161ff", NANOCBOR_ERR_INVALID_TYPE, 1 },
+        { "5f5fffff", NANOCBOR_ERR_INVALID_TYPE, 1 },
+        { "5f01ff", NANOCBOR_ERR_INVALID_TYPE, 1 },
+    };
+    uint8_t buf[16];
+    nanocbor_stack_entry_t stack[100];
+    size_t offset = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t len = strlen(cases[i].hex) / 2;
+        for (size_t j = 0; j < len; j++) {
+            unsigned byte = 0;
+            sscanf(cases[i].hex + 2 * j, "%2x", &byte);
+            buf[j] = (uint8_t)byte;
+        }
+        offset = SIZE_MAX;
+        CU_ASSERT_EQUAL(nanocbor_validate(buf, len, 0, &offset), cases[i].res);
+        CU_ASSERT_EQUAL(offset, cases[i].offset);
+    }
+
+    /* 100 nested arrays */
+    uint8_t nested[101];
+    memset(nested, 0x81, 100);
+    nested[100] = 0x00;
+    CU_ASSERT_EQUAL(nanocbor_validate(nested, sizeof(nested), 0, &offset),
+                    NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(offset, NANOCBOR_RECURSION_MAX);
+    CU_ASSERT_EQUAL(
+        nanocbor_validate_stack(nested, sizeof(nested), 0, NULL, stack, 100),
+        NANOCBOR_OK);
+}
+
+static void test_decode_utf8(void)
+{
+    /* ["a\u00e9", "\xed\xa0\x80", (_ "\xc3", "\xa9")] */
+    static const uint8_t doc[] = { 0x83, 0x63, 0x61, 0xc3, 0xa9, 0x63, 0xed,
+                                   0xa0, 0x80, 0x7f, 0x61, 0xc3, 0x61, 0xa9,
+                                   0xff };
+    /* Valid sequences of all lengths and the boundaries of the ranges */
+    static const char *const valid[]
+        = { "", "a", "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xed\x9f\xbf",
+            "\xee\x80\x80", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf" };
+    /* Overlong, surrogate, out of range, truncated and stray bytes */
+    static const char *const invalid[]
+        = { "\xc0\x80", "\xc1\xbf", "\xe0\x9f\xbf", "\xed\xa0\x80",
+            "\xf0\x8f\xbf\xbf", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+            "\xc3", "\xe2\x82", "\x80", "\xff", "\xc3\x28" };
+    char buf[80];
+    nanocbor_value_t val;
+    nanocbor_value_t arr;
+    nanocbor_value_t chunks;
+    const uint8_t *str = NULL;
+    size_t len = 0;
+
+    /* Short strings and strings long enough for the vectorized kernels, at
+     * every position in a vector */
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+        for (size_t pad = 0; pad < 70; pad += 7) {
+            memset(buf, 'x', pad);
+            strcpy(buf + pad, valid[i]);
+            CU_ASSERT_EQUAL(
+                nanocbor_check_utf8((const uint8_t *)buf, strlen(buf)),
+                NANOCBOR_OK);
+        }
+    }
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        for (size_t pad = 0; pad < 70; pad += 7) {
+            memset(buf, 'x', pad);
+            strcpy(buf + pad, invalid[i]);
+            CU_ASSERT_EQUAL(
+                nanocbor_check_utf8((const uint8_t *)buf, strlen(buf)),
+                NANOCBOR_ERR_INVALID_UTF8);
+            strcat(buf, "yyyy");
+            CU_ASSERT_EQUAL(
+                nanocbor_check_utf8((const uint8_t *)buf, strlen(buf)),
+                NANOCBOR_ERR_INVALID_UTF8);
+        }
+    }
+
+    /* Text strings are only checked in strict mode */
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&arr, &str, &len), NANOCBOR_OK);
+    nanocbor_decoder_set_strict_utf8(&val);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&val, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&arr, &str, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_tstr(&arr, &str, &len),
+                    NANOCBOR_ERR_INVALID_UTF8);
+    CU_ASSERT_EQUAL(arr.cur, doc + 5);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    /* Every chunk must be valid on its own */
+    CU_ASSERT_EQUAL(nanocbor_enter_tstr_chunks(&arr, &chunks), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_get_next_chunk(&chunks, &str, &len),
+                    NANOCBOR_ERR_INVALID_UTF8);
+
+    CU_ASSERT_EQUAL(nanocbor_validate(doc, sizeof(doc), 0, &len), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_validate(doc, sizeof(doc),
+                                      NANOCBOR_VALIDATE_FLAG_UTF8, &len),
+                    NANOCBOR_ERR_INVALID_UTF8);
+    CU_ASSERT_EQUAL(len, 5);
+}
+
+static void test_decode_deterministic(void)
+{
+    static const struct {
+        const char *hex;
+        int res;
+        size_t offset;
+    } cases[] = {
+        /* Deterministic */
+        { "", NANOCBOR_OK, 0 },
+        { "1818190100", NANOCBOR_OK, 5 },
+        { "a3010203046161f5", NANOCBOR_OK, 8 },
+        { "a2616101626161f6", NANOCBOR_OK, 8 },
+        { "c1f93c00", NANOCBOR_OK, 4 },
+        { "f97e00f97c00fa47800000fa33000000", NANOCBOR_OK, 16 },
+        { "fb3ff199999999999afb7ff8000000000001", NANOCBOR_OK, 18 },
+        /* Non-preferred arguments */
+        { "1817", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "190018", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "811a0000ffff", NANOCBOR_ERR_NOT_DETERMINISTIC, 1 },
+        { "5b00000000ffffffff", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "d81701", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        /* Floats that fit a shorter precision */
+        { "fa3f800000", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "fa7fc00000", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "fa33800000", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "fb3ff0000000000000", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "fb0000000000000000", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        /* Indefinite lengths */
+        { "9fff", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        { "5f4101ff", NANOCBOR_ERR_NOT_DETERMINISTIC, 0 },
+        /* Unsorted and duplicate keys */
+        { "a2020001f5", NANOCBOR_ERR_NOT_DETERMINISTIC, 3 },
+        { "a2626161f56162f5", NANOCBOR_ERR_NOT_DETERMINISTIC, 5 },
+        { "a2010001f5", NANOCBOR_ERR_NOT_DETERMINISTIC, 3 },
+        { "81a2616100616100", NANOCBOR_ERR_NOT_DETERMINISTIC, 5 },
+        /* Not well-formed */
+        { "8201", NANOCBOR_ERR_END, 0 },
+        { "ff", NANOCBOR_ERR_INVALID_TYPE, 0 },
+        { "f814", NANOCBOR_ERR_INVALID_TYPE, 0 },
+    };
+    uint8_t buf[32];
+    nanocbor_det_entry_t stack[100];
+    size_t offset = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t len = strlen(cases[i].hex) / 2;
+        for (size_t j = 0; j < len; j++) {
+            unsigned byte = 0;
+            sscanf(cases[i].hex + 2 * j, "%2x", &byte);
+            buf[j] = (uint8_t)byte;
+        }
+        offset = SIZE_MAX;
+        CU_ASSERT_EQUAL(nanocbor_check_deterministic(buf, len, &offset),
+                        cases[i].res);
+        CU_ASSERT_EQUAL(offset, cases[i].offset);
+    }
+
+    /* 100 nested arrays */
+    uint8_t nested[101];
+    memset(nested, 0x81, 100);
+    nested[100] = 0x00;
+    CU_ASSERT_EQUAL(nanocbor_check_deterministic(nested, sizeof(nested),
+                                                 &offset),
+                    NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(offset, NANOCBOR_RECURSION_MAX);
+    CU_ASSERT_EQUAL(nanocbor_check_deterministic_stack(nested, sizeof(nested),
+                                                       NULL, stack, 100),
+                    NANOCBOR_OK);
+}
+
+static void test_decode_map_keys(void)
+{
+    /* {1: 0, "a": 0, h'01': 0, [1]: 0} */
+    static const uint8_t unique[] = { 0xa4, 0x01, 0x00, 0x61, 0x61, 0x00, 0x41,
+                                      0x01, 0x00, 0x81, 0x01, 0x00 };
+    /* {_ 1: 0, "a": 0, 1: 0} */
+    static const uint8_t dup[] = { 0xbf, 0x01, 0x00, 0x61, 0x61,
+                                   0x00, 0x01, 0x00, 0xff };
+    /* {1: 0, 1: 0} in a different encoding is not a duplicate */
+    static const uint8_t encoding[] = { 0xa2, 0x01, 0x00, 0x18, 0x01, 0x00 };
+    nanocbor_key_slot_t table[8];
+    nanocbor_value_t it;
+
+    nanocbor_decoder_init(&it, unique, sizeof(unique));
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 8), NANOCBOR_OK);
+    /* Sorting fallback */
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 4), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 3),
+                    NANOCBOR_ERR_OVERFLOW);
+
+    nanocbor_decoder_init(&it, dup, sizeof(dup));
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 8),
+                    NANOCBOR_ERR_DUPLICATE_KEY);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 3),
+                    NANOCBOR_ERR_DUPLICATE_KEY);
+
+    nanocbor_decoder_init(&it, encoding, sizeof(encoding));
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 8), NANOCBOR_OK);
+
+    /* Not a map */
+    nanocbor_decoder_init(&it, unique + 1, sizeof(unique) - 1);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, table, 8),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* 64 unique keys followed by a duplicate of the first */
+    uint8_t buf[2 + 65 * 3];
+    buf[0] = 0xb8;
+    buf[1] = 65;
+    size_t len = 2;
+    for (unsigned i = 0; i < 65; i++) {
+        buf[len++] = 0x18;
+        buf[len++] = (uint8_t)(i < 64 ? 24 + i : 24);
+        buf[len++] = 0x00;
+    }
+    nanocbor_key_slot_t large[128];
+    buf[1] = 64;
+    nanocbor_decoder_init(&it, buf, len - 3);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, large, 128), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, large, 64), NANOCBOR_OK);
+    buf[1] = 65;
+    nanocbor_decoder_init(&it, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, large, 128),
+                    NANOCBOR_ERR_DUPLICATE_KEY);
+    CU_ASSERT_EQUAL(nanocbor_check_map_keys(&it, large, 65),
+                    NANOCBOR_ERR_DUPLICATE_KEY);
+}
+
+static void _decode_segments(const nanocbor_iovec_t *segs, size_t num)
+{
+    nanocbor_seg_value_t it;
+    nanocbor_seg_value_t map;
+    nanocbor_seg_value_t arr;
+    uint8_t scratch[32];
+    const uint8_t *buf = NULL;
+    size_t len = 0;
+    uint64_t uvalue = 0;
+    int64_t ivalue = 0;
+    uint32_t tag = 0;
+    float fvalue = 0;
+    double dvalue = 0;
+    bool bvalue = false;
+
+    nanocbor_seg_decoder_init(&it, segs, num);
+    CU_ASSERT_EQUAL(nanocbor_seg_enter_map(&it, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_tstr(&map, &buf, &len, scratch, 32),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 3);
+    CU_ASSERT_EQUAL(memcmp(buf, "key", 3), 0);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_bstr(&map, &buf, &len, scratch, 32),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 20);
+    CU_ASSERT_EQUAL(buf[19], 19);
+
+    CU_ASSERT_EQUAL(nanocbor_seg_get_tstr(&map, &buf, &len, scratch, 32),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_enter_array(&map, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_uint64(&arr, &uvalue), 1);
+    CU_ASSERT_EQUAL(uvalue, 1);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_uint64(&arr, &uvalue), 3);
+    CU_ASSERT_EQUAL(uvalue, 1000);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_uint64(&arr, &uvalue),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_int64(&arr, &ivalue), 1);
+    CU_ASSERT_EQUAL(ivalue, -5);
+    CU_ASSERT(nanocbor_seg_at_end(&arr));
+    nanocbor_seg_leave_container(&map, &arr);
+
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_tag(&map, &tag), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(tag, 55);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_tstr(&map, &buf, &len, scratch, 32),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(len, 11);
+    CU_ASSERT_EQUAL(memcmp(buf, "hello world", 11), 0);
+
+    /* Indefinite array with a nested array */
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&map), NANOCBOR_OK);
+
+    /* Floating point and simple values */
+    CU_ASSERT_EQUAL(nanocbor_seg_get_tstr(&map, &buf, &len, scratch, 32),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_enter_array(&map, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_bool(&arr, &bvalue),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_float(&arr, &fvalue), 3);
+    CU_ASSERT_EQUAL(fvalue, 1.5f);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_float(&arr, &fvalue),
+                    NANOCBOR_ERR_OVERFLOW);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_double(&arr, &dvalue), 9);
+    CU_ASSERT_EQUAL(dvalue, 1.1);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_null(&arr), NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_bool(&arr, &bvalue), NANOCBOR_OK);
+    CU_ASSERT(bvalue);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_null(&arr), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_seg_at_end(&arr));
+    CU_ASSERT_EQUAL(nanocbor_seg_get_null(&arr), NANOCBOR_ERR_END);
+    nanocbor_seg_leave_container(&map, &arr);
+    CU_ASSERT(nanocbor_seg_at_end(&map));
+    nanocbor_seg_leave_container(&it, &map);
+    CU_ASSERT(nanocbor_seg_at_end(&it));
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&it), NANOCBOR_ERR_END);
+}
+
+static void test_decode_segments(void)
+{
+    uint8_t buf[96];
+    uint8_t payload[20];
+    nanocbor_encoder_t enc;
+    nanocbor_iovec_t segs[96];
+
+    for (uint8_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i;
+    }
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_map(&enc, 5);
+    nanocbor_put_tstr(&enc, "key");
+    nanocbor_put_bstr(&enc, payload, sizeof(payload));
+    nanocbor_put_tstr(&enc, "n");
+    nanocbor_fmt_array(&enc, 3);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, 1000);
+    nanocbor_fmt_int(&enc, -5);
+    nanocbor_put_tstr(&enc, "t");
+    nanocbor_fmt_tag(&enc, 55);
+    nanocbor_put_tstr(&enc, "hello world");
+    nanocbor_put_tstr(&enc, "s");
+    nanocbor_fmt_array_indefinite(&enc);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_array(&enc, 2);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 3);
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_put_tstr(&enc, "f");
+    nanocbor_fmt_array(&enc, 4);
+    nanocbor_fmt_float(&enc, 1.5f);
+    nanocbor_fmt_double(&enc, 1.1);
+    nanocbor_fmt_bool(&enc, true);
+    nanocbor_fmt_null(&enc);
+    size_t len = nanocbor_encoded_len(&enc);
+
+    /* Contiguous strings are not copied */
+    nanocbor_seg_value_t it;
+    nanocbor_seg_value_t map;
+    const uint8_t *str = NULL;
+    size_t str_len = 0;
+    segs[0].base = buf;
+    segs[0].len = len;
+    nanocbor_seg_decoder_init(&it, segs, 1);
+    nanocbor_seg_enter_map(&it, &map);
+    nanocbor_seg_skip(&map);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_bstr(&map, &str, &str_len, NULL, 0),
+                    NANOCBOR_OK);
+    CU_ASSERT_PTR_EQUAL(str, buf + 6);
+    _decode_segments(segs, 1);
+
+    /* Split in two at every offset, with an empty segment in between */
+    for (size_t split = 0; split <= len; split++) {
+        segs[0].len = split;
+        segs[1].base = buf + split;
+        segs[1].len = 0;
+        segs[2].base = buf + split;
+        segs[2].len = len - split;
+        _decode_segments(segs, 3);
+    }
+
+    /* Single byte segments */
+    for (size_t i = 0; i < len; i++) {
+        segs[i].base = buf + i;
+        segs[i].len = 1;
+    }
+    _decode_segments(segs, len);
+
+    /* Straddling strings need scratch space */
+    nanocbor_seg_decoder_init(&it, segs, len);
+    nanocbor_seg_enter_map(&it, &map);
+    nanocbor_seg_skip(&map);
+    CU_ASSERT_EQUAL(nanocbor_seg_get_bstr(&map, &str, &str_len, NULL, 0),
+                    NANOCBOR_ERR_OVERFLOW);
+
+    /* Truncated */
+    nanocbor_seg_decoder_init(&it, segs, len - 1);
+    nanocbor_seg_enter_map(&it, &map);
+    for (unsigned i = 0; i < 9; i++) {
+        CU_ASSERT_EQUAL(nanocbor_seg_skip(&map), NANOCBOR_OK);
+    }
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&map), NANOCBOR_ERR_END);
+
+    /* Map with 2^63 pairs */
+    static const uint8_t huge_map[]
+        = { 0xbb, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    segs[0].base = huge_map;
+    segs[0].len = sizeof(huge_map);
+    nanocbor_seg_decoder_init(&it, segs, 1);
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&it), NANOCBOR_ERR_OVERFLOW);
+
+    /* 100 nested arrays */
+    nanocbor_stack_entry_t stack[100];
+    uint8_t nested[101];
+    memset(nested, 0x81, 100);
+    nested[100] = 0x00;
+    segs[0].base = nested;
+    segs[0].len = 50;
+    segs[1].base = nested + 50;
+    segs[1].len = sizeof(nested) - 50;
+    nanocbor_seg_decoder_init(&it, segs, 2);
+    CU_ASSERT_EQUAL(nanocbor_seg_skip(&it), NANOCBOR_ERR_RECURSION);
+    CU_ASSERT_EQUAL(nanocbor_seg_skip_stack(&it, stack, 100), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_seg_at_end(&it));
+}
+
+static void test_decode_index(void)
+{
+    /* {"a": [1, [2, 3], {"x": 4}], "b": 5, "c": [_ 6, h'0708'], "d": 24(7)} */
+    static const uint8_t doc[]
+        = { 0xa4, 0x61, 0x61, 0x83, 0x01, 0x82, 0x02, 0x03, 0xa1, 0x61,
+            0x78, 0x04, 0x61, 0x62, 0x05, 0x61, 0x63, 0x9f, 0x06, 0x42,
+            0x07, 0x08, 0xff, 0x61, 0x64, 0xd8, 0x18, 0x07 };
+    static const uint8_t truncated[] = { 0x82, 0x01 };
+
+    nanocbor_index_entry_t entries[19];
+    nanocbor_index_t index;
+    nanocbor_value_t val;
+    nanocbor_value_t map;
+    nanocbor_value_t arr;
+    nanocbor_value_t found;
+    uint32_t tmp = 0;
+
+    nanocbor_index_init(&index, entries, 3);
+    CU_ASSERT_EQUAL(nanocbor_index_build(&index, doc, sizeof(doc)),
+                    NANOCBOR_ERR_OVERFLOW);
+    nanocbor_index_init(&index, entries, 19);
+    CU_ASSERT_EQUAL(nanocbor_index_build(&index, truncated, sizeof(truncated)),
+                    NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_index_build(&index, doc, sizeof(doc)), 19);
+
+    /* Root map covers the whole buffer */
+    const nanocbor_index_entry_t *entry = nanocbor_index_lookup(&index, doc);
+    CU_ASSERT_PTR_NOT_NULL(entry);
+    CU_ASSERT_EQUAL(entry->type, NANOCBOR_TYPE_MAP);
+    CU_ASSERT_EQUAL(entry->argument, 4);
+    CU_ASSERT_EQUAL(entry->end, sizeof(doc));
+    CU_ASSERT_EQUAL(entry->next, 19);
+    CU_ASSERT_PTR_NULL(nanocbor_index_lookup(&index, doc + 2));
+
+    /* Indefinite array */
+    entry = nanocbor_index_lookup(&index, doc + 17);
+    CU_ASSERT_PTR_NOT_NULL(entry);
+    CU_ASSERT_EQUAL(entry->flags, NANOCBOR_INDEX_FLAG_INDEFINITE);
+    CU_ASSERT_EQUAL(entry->end, 23);
+
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&val, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(
+        nanocbor_index_get_key_tstr(&index, &map, "d", &found), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(found.cur, doc + 25);
+    CU_ASSERT_EQUAL(
+        nanocbor_index_get_key_tstr(&index, &map, "e", &found),
+        NANOCBOR_NOT_FOUND);
+    CU_ASSERT_EQUAL(
+        nanocbor_index_get_key_tstr(&index, &map, "a", &found), NANOCBOR_OK);
+
+    /* Jump to the last element of the array */
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&found, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_skip_items(&index, &arr, 2), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_enter_map(&arr, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_skip(&index, &map), NANOCBOR_OK);
+    CU_ASSERT(nanocbor_get_uint32(&map, &tmp) > 0);
+    CU_ASSERT_EQUAL(tmp, 4);
+    nanocbor_leave_container(&arr, &map);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+    CU_ASSERT_EQUAL(nanocbor_index_skip(&index, &arr), NANOCBOR_ERR_END);
+
+    /* Skip over nested elements up to and past the end of the array */
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&found, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_skip_items(&index, &arr, 0), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_skip_items(&index, &arr, 3), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&arr), true);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&found, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_index_skip_items(&index, &arr, 4),
+                    NANOCBOR_ERR_END);
+
+    /* Skipping the whole document is a single lookup */
+    nanocbor_decoder_init(&val, doc, sizeof(doc));
+    CU_ASSERT_EQUAL(nanocbor_index_skip(&index, &val), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+}
+
 const test_t tests_decoder[] = {
     {
         .f = test_decode_none,
@@ -273,10 +1419,74 @@ const test_t tests_decoder[] = {
         .f = test_double_tag,
         .n = "CBOR double tag decode test",
     },
+    {
+        .f = test_decode_float,
+        .n = "CBOR float decode test",
+    },
+    {
+        .f = test_decode_header,
+        .n = "CBOR header peek test",
+    },
+    {
+        .f = test_decode_bulk_array,
+        .n = "CBOR bulk array decode test",
+    },
     {
         .f = test_decode_skip,
         .n = "CBOR simple skip test",
     },
+    {
+        .f = test_decode_skip_stack,
+        .n = "CBOR non-recursive skip test",
+    },
+    {
+        .f = test_decode_index,
+        .n = "CBOR structural index test",
+    },
+    {
+        .f = test_decode_stream,
+        .n = "CBOR streaming decoder test",
+    },
+    {
+        .f = test_decode_str_chunks,
+        .n = "CBOR indefinite length string test",
+    },
+    {
+        .f = test_decode_keys,
+        .n = "CBOR multiple key lookup test",
+    },
+    {
+        .f = test_decode_key_int,
+        .n = "CBOR integer key lookup test",
+    },
+    {
+        .f = test_decode_struct,
+        .n = "CBOR struct binding test",
+    },
+    {
+        .f = test_decode_events,
+        .n = "CBOR event parser test",
+    },
+    {
+        .f = test_decode_validate,
+        .n = "CBOR well-formedness validation test",
+    },
+    {
+        .f = test_decode_utf8,
+        .n = "CBOR UTF-8 validation test",
+    },
+    {
+        .f = test_decode_deterministic,
+        .n = "CBOR deterministic encoding check test",
+    },
+    {
+        .f = test_decode_map_keys,
+        .n = "CBOR duplicate map key test",
+    },
+    {
+        .f = test_decode_segments,
+        .n = "CBOR scatter-gather decode test",
+    },
     {
         .f = NULL,
         .n = NULL,
@@ -2,11 +2,14 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include "nanocbor/config.h"
 #include "nanocbor/nanocbor.h"
 #include "test.h"
 #include <CUnit/CUnit.h>
 #include <float.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 static void print_bytestr(const uint8_t *bytes, size_t len)
 {
@@ -89,6 +92,567 @@ static void test_encode_double_to_float(void)
     print_bytestr(buf, nanocbor_encoded_len(&enc));
 }
 
+static void test_encode_typed_array(void)
+{
+    static const float samples[] = { 1.5F, -2.25F, 1000.0F };
+    /* uint16 big endian typed array: 65(h'0102ff00') */
+    static const uint8_t be16[]
+        = { 0xd8, 0x41, 0x44, 0x01, 0x02, 0xff, 0x00 };
+    uint8_t buf[64];
+    float fconv[3];
+    uint16_t conv[2];
+    nanocbor_encoder_t enc;
+    nanocbor_value_t val;
+    nanocbor_typed_array_t array;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_put_typed_array(&enc, 63, samples, 3),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_put_typed_array(&enc, NANOCBOR_TAG_TYPED_FLOAT32,
+                                             samples, 3),
+                    NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 2 + 1 + 12);
+
+    nanocbor_decoder_init(&val, buf, nanocbor_encoded_len(&enc));
+    CU_ASSERT_EQUAL(nanocbor_get_typed_array(&val, &array), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(array.num, 3);
+    CU_ASSERT_EQUAL(array.elem_size, sizeof(float));
+    const float *fvalues
+        = nanocbor_typed_array_elements(&array, fconv, sizeof(fconv));
+    CU_ASSERT_PTR_NOT_NULL(fvalues);
+    CU_ASSERT_EQUAL(fvalues[0], 1.5F);
+    CU_ASSERT_EQUAL(fvalues[1], -2.25F);
+    CU_ASSERT_EQUAL(fvalues[2], 1000.0F);
+    CU_ASSERT_EQUAL(nanocbor_at_end(&val), true);
+
+    nanocbor_decoder_init(&val, be16, sizeof(be16));
+    CU_ASSERT_EQUAL(nanocbor_get_typed_array(&val, &array), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(array.num, 2);
+    CU_ASSERT_PTR_NULL(nanocbor_typed_array_elements(&array, conv, 3));
+    const uint16_t *values
+        = nanocbor_typed_array_elements(&array, conv, sizeof(conv));
+    CU_ASSERT_PTR_NOT_NULL(values);
+    CU_ASSERT_EQUAL(values[0], 0x0102);
+    CU_ASSERT_EQUAL(values[1], 0xff00);
+}
+
+static void test_encode_sorted_map(void)
+{
+    /* {10: {"a": [1], "z": 0}, "b": 1, "aa": 2} */
+    static const uint8_t expected[]
+        = { 0xa3, 0x0a, 0xa2, 0x61, 0x61, 0x81, 0x01, 0x61, 0x7a, 0x00,
+            0x61, 0x62, 0x01, 0x62, 0x61, 0x61, 0x02 };
+    uint8_t buf[64];
+    uint8_t arena[128];
+    uint8_t inner_arena[64];
+    nanocbor_encoder_t enc;
+    nanocbor_sorted_map_t map;
+    nanocbor_sorted_map_t inner;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_encoder_set_canonical(&enc);
+    CU_ASSERT_EQUAL(nanocbor_fmt_array_indefinite(&enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 0);
+
+    nanocbor_fmt_sorted_map_open(&enc, &map, arena, sizeof(arena));
+    nanocbor_put_tstr(&map.enc, "b");
+    nanocbor_fmt_uint(&map.enc, 1);
+    nanocbor_fmt_uint(&map.enc, 10);
+    nanocbor_fmt_sorted_map_open(&map.enc, &inner, inner_arena,
+                                 sizeof(inner_arena));
+    CU_ASSERT_EQUAL(nanocbor_fmt_map_indefinite(&inner.enc),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    nanocbor_put_tstr(&inner.enc, "z");
+    nanocbor_fmt_uint(&inner.enc, 0);
+    nanocbor_put_tstr(&inner.enc, "a");
+    nanocbor_fmt_array(&inner.enc, 1);
+    nanocbor_fmt_uint(&inner.enc, 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&inner), NANOCBOR_OK);
+    nanocbor_put_tstr(&map.enc, "aa");
+    nanocbor_fmt_uint(&map.enc, 2);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 0);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map), NANOCBOR_OK);
+
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), sizeof(expected));
+    CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(expected)), 0);
+    CU_ASSERT_EQUAL(nanocbor_check_deterministic(buf, sizeof(expected), NULL),
+                    NANOCBOR_OK);
+
+    /* Duplicate keys */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_sorted_map_open(&enc, &map, arena, sizeof(arena));
+    nanocbor_fmt_uint(&map.enc, 1);
+    nanocbor_fmt_null(&map.enc);
+    nanocbor_fmt_uint(&map.enc, 1);
+    nanocbor_fmt_null(&map.enc);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map),
+                    NANOCBOR_ERR_DUPLICATE_KEY);
+
+    /* {1: null, 2: [[...[null]...]]}, nested beyond the decoder recursion
+     * limit */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_sorted_map_open(&enc, &map, arena, sizeof(arena));
+    nanocbor_fmt_uint(&map.enc, 2);
+    for (unsigned i = 0; i < NANOCBOR_RECURSION_MAX + 2; i++) {
+        nanocbor_fmt_array(&map.enc, 1);
+    }
+    nanocbor_fmt_null(&map.enc);
+    nanocbor_fmt_uint(&map.enc, 1);
+    nanocbor_fmt_null(&map.enc);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc),
+                    1 + 2 + 1 + NANOCBOR_RECURSION_MAX + 2 + 1);
+    CU_ASSERT_EQUAL(memcmp(buf, "\xa2\x01\xf6\x02\x81", 5), 0);
+
+    /* Arena without space for the index */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_sorted_map_open(&enc, &map, arena, 4);
+    nanocbor_fmt_uint(&map.enc, 1);
+    nanocbor_fmt_null(&map.enc);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map), NANOCBOR_ERR_END);
+
+    /* Key without a value */
+    nanocbor_fmt_sorted_map_open(&enc, &map, arena, sizeof(arena));
+    nanocbor_fmt_uint(&map.enc, 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 0);
+}
+
+static void test_encode_uint_bounds(void)
+{
+    uint8_t buf[4];
+    nanocbor_encoder_t enc;
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 23), 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_int(&enc, -24), 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 24), 2);
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 0), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 1000), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(buf[0], 0x17);
+    CU_ASSERT_EQUAL(buf[1], 0x37);
+    CU_ASSERT_EQUAL(buf[2], 0x18);
+    CU_ASSERT_EQUAL(buf[3], 0x18);
+    /* The length keeps counting for sizing */
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 8);
+
+    nanocbor_encoder_init(&enc, NULL, 0);
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 1), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), 1);
+}
+
+static bool _stream_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)len;
+    return true;
+}
+
+static void _stream_append(nanocbor_encoder_t *enc, void *ctx,
+                           const uint8_t *data, size_t len)
+{
+    (void)enc;
+    (void)ctx;
+    (void)data;
+    (void)len;
+}
+
+static void _fmt_record(nanocbor_encoder_t *enc, bool unchecked)
+{
+    static const uint8_t id[4] = { 0xde, 0xad, 0xbe, 0xef };
+
+    if (unchecked) {
+        nanocbor_fmt_map_unchecked(enc, 5);
+        nanocbor_fmt_uint_unchecked(enc, 1);
+        nanocbor_put_bstr_unchecked(enc, id, sizeof(id));
+        nanocbor_fmt_uint_unchecked(enc, 2);
+        nanocbor_fmt_int_unchecked(enc, INT64_MIN);
+        nanocbor_fmt_int_unchecked(enc, -3);
+        nanocbor_fmt_tag_unchecked(enc, 1);
+        nanocbor_fmt_uint_unchecked(enc, 1700000000);
+        nanocbor_put_tstrn_unchecked(enc, "ok", 2);
+        nanocbor_fmt_array_unchecked(enc, 2);
+        nanocbor_fmt_bool_unchecked(enc, true);
+        nanocbor_fmt_null_unchecked(enc);
+        nanocbor_fmt_uint_unchecked(enc, 300);
+        return;
+    }
+    nanocbor_fmt_map(enc, 5);
+    nanocbor_fmt_uint(enc, 1);
+    nanocbor_put_bstr(enc, id, sizeof(id));
+    nanocbor_fmt_uint(enc, 2);
+    nanocbor_fmt_int(enc, INT64_MIN);
+    nanocbor_fmt_int(enc, -3);
+    nanocbor_fmt_tag(enc, 1);
+    nanocbor_fmt_uint(enc, 1700000000);
+    nanocbor_put_tstrn(enc, "ok", 2);
+    nanocbor_fmt_array(enc, 2);
+    nanocbor_fmt_bool(enc, true);
+    nanocbor_fmt_null(enc);
+    nanocbor_fmt_uint(enc, 300);
+}
+
+static void test_encode_unchecked(void)
+{
+    uint8_t checked[64];
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+    nanocbor_encoder_t ref;
+
+    nanocbor_encoder_init(&ref, checked, sizeof(checked));
+    _fmt_record(&ref, false);
+    size_t len = nanocbor_encoded_len(&ref);
+
+    nanocbor_encoder_init(&enc, buf, len - 1);
+    CU_ASSERT_EQUAL(nanocbor_reserve(&enc, len), NANOCBOR_ERR_END);
+    nanocbor_encoder_init(&enc, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_reserve(&enc, len), NANOCBOR_OK);
+    _fmt_record(&enc, true);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), len);
+    CU_ASSERT_EQUAL(memcmp(buf, checked, len), 0);
+
+    nanocbor_encoder_stream_init(&enc, NULL, _stream_append, _stream_fits);
+    CU_ASSERT_EQUAL(nanocbor_reserve(&enc, 1), NANOCBOR_ERR_INVALID_TYPE);
+
+    /* Staged sorted map items also take index space */
+    size_t arena[4];
+    uint8_t *staged = (uint8_t *)arena;
+    nanocbor_sorted_map_t map;
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_sorted_map_open(&enc, &map, staged, sizeof(arena));
+    CU_ASSERT_EQUAL(nanocbor_reserve(&map.enc, 4), NANOCBOR_ERR_INVALID_TYPE);
+    /* Unchecked writes past the index never let an offset overwrite the
+     * staged items */
+    for (uint8_t i = 0; i < 4; i++) {
+        nanocbor_fmt_uint_unchecked(&map.enc, i);
+    }
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&map.enc, 4), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(memcmp(staged, "\x00\x01\x02\x03", 4), 0);
+    CU_ASSERT_EQUAL(nanocbor_fmt_sorted_map_close(&map), NANOCBOR_ERR_END);
+}
+
+static void test_encode_size(void)
+{
+    uint8_t buf[128];
+    nanocbor_encoder_t enc;
+    nanocbor_encoder_t size;
+    static const int64_t ints[] = { 0, 23, 24, 255, 256, 65535, 65536,
+                                    UINT32_MAX, (int64_t)UINT32_MAX + 1,
+                                    -1, -24, -25, -257, INT64_MIN };
+    static const double doubles[] = { 0.0, 1.5, 65504.0, 100000.0, 1.1,
+                                      3.4028234663852886e+38, 1e300 };
+
+    /* Constant expressions */
+    static const size_t constants[] = {
+        NANOCBOR_ENCODED_SIZE_UINT(23),
+        NANOCBOR_ENCODED_SIZE_UINT(UINT32_MAX),
+        NANOCBOR_ENCODED_SIZE_INT(-25),
+        NANOCBOR_ENCODED_SIZE_STR(300),
+    };
+
+    CU_ASSERT_EQUAL(constants[0], 1);
+    CU_ASSERT_EQUAL(constants[1], 5);
+    CU_ASSERT_EQUAL(constants[2], 2);
+    CU_ASSERT_EQUAL(constants[3], 303);
+
+    for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        nanocbor_encoder_init(&enc, buf, sizeof(buf));
+        nanocbor_fmt_int(&enc, ints[i]);
+        CU_ASSERT_EQUAL(nanocbor_size_int(ints[i]), nanocbor_encoded_len(&enc));
+        CU_ASSERT_EQUAL(NANOCBOR_ENCODED_SIZE_INT(ints[i]),
+                        nanocbor_encoded_len(&enc));
+        if (ints[i] >= 0) {
+            CU_ASSERT_EQUAL(nanocbor_size_uint((uint64_t)ints[i]),
+                            nanocbor_encoded_len(&enc));
+        }
+    }
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++) {
+        nanocbor_encoder_init(&enc, buf, sizeof(buf));
+        nanocbor_fmt_double(&enc, doubles[i]);
+        CU_ASSERT_EQUAL(nanocbor_size_double(doubles[i]),
+                        nanocbor_encoded_len(&enc));
+        nanocbor_encoder_init(&enc, buf, sizeof(buf));
+        nanocbor_fmt_float(&enc, (float)doubles[i]);
+        CU_ASSERT_EQUAL(nanocbor_size_float((float)doubles[i]),
+                        nanocbor_encoded_len(&enc));
+    }
+    CU_ASSERT_EQUAL(nanocbor_size_str(24), 26);
+
+    /* Size only encoder */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_encoder_size_init(&size);
+    _fmt_record(&enc, false);
+    _fmt_record(&size, false);
+    CU_ASSERT_EQUAL(nanocbor_fmt_double(&size, 1.1), 9);
+    CU_ASSERT_EQUAL(nanocbor_put_tstr(&size, "size"), NANOCBOR_OK);
+    nanocbor_fmt_double(&enc, 1.1);
+    nanocbor_put_tstr(&enc, "size");
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&size), nanocbor_encoded_len(&enc));
+}
+
+static void test_encode_container_close(void)
+{
+    /* [{1: [], 2: 3}, 0, 1, ..., 29], up to the first two byte integer */
+    uint8_t expected[2 + 5 + 24];
+    uint8_t buf[64];
+    nanocbor_encoder_t enc;
+    nanocbor_container_t array;
+    nanocbor_container_t map;
+    nanocbor_container_t empty;
+
+    expected[0] = 0x98;
+    expected[1] = 31;
+    memcpy(expected + 2, "\xa2\x01\x80\x02\x03", 5);
+    for (uint8_t i = 0; i < 24; i++) {
+        expected[7 + i] = i;
+    }
+
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    CU_ASSERT_EQUAL(nanocbor_fmt_array_open(&enc, &array), 9);
+    CU_ASSERT_EQUAL(nanocbor_fmt_map_open(&enc, &map), 9);
+    nanocbor_fmt_uint(&enc, 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_array_open(&enc, &empty), 9);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &empty), NANOCBOR_OK);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 3);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &map), NANOCBOR_OK);
+    for (uint8_t i = 0; i < 30; i++) {
+        nanocbor_fmt_uint(&enc, i);
+    }
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array), NANOCBOR_OK);
+
+    size_t len = nanocbor_encoded_len(&enc);
+    CU_ASSERT_EQUAL(len, 2 + 5 + 24 + 6 * 2);
+    CU_ASSERT_EQUAL(memcmp(buf, expected, sizeof(expected)), 0);
+    nanocbor_value_t it;
+    nanocbor_value_t arr;
+    uint32_t value = 0;
+    nanocbor_decoder_init(&it, buf, len);
+    CU_ASSERT_EQUAL(nanocbor_enter_array(&it, &arr), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_skip(&arr), NANOCBOR_OK);
+    for (uint32_t i = 0; i < 30; i++) {
+        CU_ASSERT(nanocbor_get_uint32(&arr, &value) > 0);
+        CU_ASSERT_EQUAL(value, i);
+    }
+    CU_ASSERT(nanocbor_at_end(&arr));
+
+    /* [[[...[null]...]], 1([_ 1, {2: 3}]), "ab"], nested beyond the
+     * decoder recursion limit */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_array_open(&enc, &array);
+    for (unsigned i = 0; i < NANOCBOR_RECURSION_MAX + 2; i++) {
+        nanocbor_fmt_array(&enc, 1);
+    }
+    nanocbor_fmt_null(&enc);
+    nanocbor_fmt_tag(&enc, 1);
+    nanocbor_fmt_array_indefinite(&enc);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_map(&enc, 1);
+    nanocbor_fmt_uint(&enc, 2);
+    nanocbor_fmt_uint(&enc, 3);
+    nanocbor_fmt_end_indefinite(&enc);
+    nanocbor_put_tstr(&enc, "ab");
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(buf[0], 0x83);
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc),
+                    1 + NANOCBOR_RECURSION_MAX + 2 + 8 + 3);
+
+    /* Key without a value */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_map_open(&enc, &map);
+    nanocbor_fmt_uint(&enc, 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &map),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* Array missing an item */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_array_open(&enc, &array);
+    nanocbor_fmt_array(&enc, 2);
+    nanocbor_fmt_uint(&enc, 1);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array),
+                    NANOCBOR_ERR_INVALID_TYPE);
+
+    /* Items that do not fit */
+    nanocbor_encoder_init(&enc, buf, 10);
+    nanocbor_fmt_array_open(&enc, &array);
+    nanocbor_fmt_uint(&enc, 1);
+    nanocbor_fmt_uint(&enc, 2);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array),
+                    NANOCBOR_ERR_END);
+    nanocbor_encoder_init(&enc, buf, 8);
+    CU_ASSERT_EQUAL(nanocbor_fmt_array_open(&enc, &array), NANOCBOR_ERR_END);
+    CU_ASSERT_PTR_NULL(enc.container);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array),
+                    NANOCBOR_ERR_END);
+
+    /* Containers are closed innermost first */
+    nanocbor_encoder_init(&enc, buf, sizeof(buf));
+    nanocbor_fmt_array_open(&enc, &array);
+    nanocbor_fmt_map_open(&enc, &map);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array),
+                    NANOCBOR_ERR_INVALID_TYPE);
+    CU_ASSERT_PTR_EQUAL(enc.container, &map);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &map), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_fmt_container_close(&enc, &array), NANOCBOR_OK);
+    CU_ASSERT_PTR_NULL(enc.container);
+    CU_ASSERT_EQUAL(memcmp(buf, "\x81\xa0", 2), 0);
+
+    /* Headers can not be patched in a stream */
+    nanocbor_encoder_stream_init(&enc, NULL, _stream_append, _stream_fits);
+    CU_ASSERT_EQUAL(nanocbor_fmt_array_open(&enc, &array),
+                    NANOCBOR_ERR_INVALID_TYPE);
+}
+
+static void *_failing_realloc(void *ctx, void *ptr, size_t len)
+{
+    size_t *limit = ctx;
+    return len > *limit ? NULL : realloc(ptr, len);
+}
+
+static void test_encode_growable(void)
+{
+    uint8_t buf[4096];
+    nanocbor_encoder_t fixed;
+    nanocbor_encoder_t enc;
+    nanocbor_growbuf_t grow;
+
+    nanocbor_encoder_init(&fixed, buf, sizeof(buf));
+    nanocbor_encoder_growable_init(&enc, &grow, NULL, NULL);
+    CU_ASSERT_PTR_NULL(grow.buf);
+    for (uint32_t i = 0; i < 500; i++) {
+        nanocbor_fmt_uint(&fixed, i * 1000);
+        CU_ASSERT(nanocbor_fmt_uint(&enc, i * 1000) > 0);
+    }
+    CU_ASSERT_EQUAL(nanocbor_put_tstr(&enc, "end"), NANOCBOR_OK);
+    nanocbor_put_tstr(&fixed, "end");
+    CU_ASSERT_EQUAL(grow.len, nanocbor_encoded_len(&fixed));
+    CU_ASSERT_EQUAL(grow.len, nanocbor_encoded_len(&enc));
+    CU_ASSERT(grow.capacity >= grow.len);
+    CU_ASSERT(grow.capacity < 2 * grow.len);
+    CU_ASSERT_EQUAL(memcmp(grow.buf, buf, grow.len), 0);
+    free(grow.buf);
+
+    /* Allocator failure */
+    size_t limit = 128;
+    nanocbor_encoder_growable_init(&enc, &grow, _failing_realloc, &limit);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr(&enc, buf, 100), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr(&enc, buf, 100), NANOCBOR_ERR_END);
+    /* Only the header of the second string fit */
+    CU_ASSERT_EQUAL(grow.len, 104);
+    free(grow.buf);
+}
+
+typedef struct {
+    uint8_t buf[512];
+    size_t len;
+    size_t calls;
+} sink_t;
+
+static bool _sink_fits(nanocbor_encoder_t *enc, void *ctx, size_t len)
+{
+    sink_t *sink = ctx;
+    (void)enc;
+    return sizeof(sink->buf) - sink->len >= len;
+}
+
+static void _sink_append(nanocbor_encoder_t *enc, void *ctx,
+                         const uint8_t *data, size_t len)
+{
+    sink_t *sink = ctx;
+    (void)enc;
+    memcpy(sink->buf + sink->len, data, len);
+    sink->len += len;
+    sink->calls++;
+}
+
+static void test_encode_buffered(void)
+{
+    static const uint8_t payload[100] = { 0 };
+    uint8_t buf[512];
+    uint8_t staging[32];
+    nanocbor_encoder_t fixed;
+    nanocbor_encoder_t enc;
+    nanocbor_stream_buf_t stream;
+    sink_t sink = { .len = 0, .calls = 0 };
+
+    nanocbor_encoder_init(&fixed, buf, sizeof(buf));
+    nanocbor_encoder_buffered_init(&enc, &stream, staging, sizeof(staging),
+                                   &sink, _sink_append, _sink_fits);
+    for (uint32_t i = 0; i < 20; i++) {
+        nanocbor_fmt_uint(&fixed, i * 1000);
+        nanocbor_fmt_uint(&enc, i * 1000);
+    }
+    nanocbor_put_bstr(&fixed, payload, sizeof(payload));
+    nanocbor_put_bstr(&enc, payload, sizeof(payload));
+    nanocbor_fmt_double(&fixed, 1.1);
+    nanocbor_fmt_double(&enc, 1.1);
+    /* 60 bytes of headers in two blocks, the payload directly */
+    CU_ASSERT_EQUAL(sink.calls, 3);
+    CU_ASSERT_EQUAL(nanocbor_encoder_flush(&enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoder_flush(&enc), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(sink.calls, 4);
+    CU_ASSERT_EQUAL(sink.len, nanocbor_encoded_len(&fixed));
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), nanocbor_encoded_len(&fixed));
+    CU_ASSERT_EQUAL(memcmp(sink.buf, buf, sink.len), 0);
+
+    /* Sink full */
+    sink.len = sizeof(sink.buf) - 4;
+    nanocbor_encoder_buffered_init(&enc, &stream, staging, sizeof(staging),
+                                   &sink, _sink_append, _sink_fits);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr(&enc, payload, 8), NANOCBOR_OK);
+    CU_ASSERT_EQUAL(nanocbor_encoder_flush(&enc), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(nanocbor_put_bstr(&enc, payload, 100), NANOCBOR_ERR_END);
+}
+
+static void test_encode_iovec(void)
+{
+    static const uint8_t payload[300] = { 1, 2, 3 };
+    uint8_t buf[512];
+    uint8_t out[512];
+    uint8_t headers[32];
+    nanocbor_iovec_t iov[4];
+    nanocbor_encoder_t fixed;
+    nanocbor_encoder_t enc;
+    nanocbor_iovec_buf_t vec;
+
+    nanocbor_encoder_init(&fixed, buf, sizeof(buf));
+    nanocbor_encoder_iovec_init(&enc, &vec, iov, 4, headers, sizeof(headers),
+                                64);
+    nanocbor_fmt_array(&fixed, 4);
+    nanocbor_fmt_array(&enc, 4);
+    nanocbor_put_tstr(&fixed, "small");
+    nanocbor_put_tstr(&enc, "small");
+    nanocbor_put_bstr(&fixed, payload, sizeof(payload));
+    CU_ASSERT_EQUAL(nanocbor_put_bstr(&enc, payload, sizeof(payload)),
+                    NANOCBOR_OK);
+    nanocbor_fmt_uint(&fixed, 1000);
+    nanocbor_fmt_uint(&enc, 1000);
+    nanocbor_put_bstr(&fixed, payload, 64);
+    nanocbor_put_bstr(&enc, payload, 64);
+
+    /* Header run, payload, header run, payload */
+    CU_ASSERT_EQUAL(vec.num, 4);
+    CU_ASSERT_PTR_EQUAL(iov[1].base, payload);
+    CU_ASSERT_EQUAL(iov[1].len, sizeof(payload));
+    CU_ASSERT_EQUAL(iov[2].len, 3 + 2);
+    CU_ASSERT_PTR_EQUAL(iov[3].base, payload);
+    size_t len = 0;
+    for (size_t i = 0; i < vec.num; i++) {
+        memcpy(out + len, iov[i].base, iov[i].len);
+        len += iov[i].len;
+    }
+    CU_ASSERT_EQUAL(len, nanocbor_encoded_len(&fixed));
+    CU_ASSERT_EQUAL(nanocbor_encoded_len(&enc), len);
+    CU_ASSERT_EQUAL(memcmp(out, buf, len), 0);
+
+    /* Out of vectors */
+    CU_ASSERT_EQUAL(nanocbor_fmt_uint(&enc, 1), NANOCBOR_ERR_END);
+    CU_ASSERT_EQUAL(vec.num, 4);
+}
+
 const test_t tests_encoder[] = {
     {
         .f = test_encode_float_specials,
@@ -102,6 +666,42 @@ const test_t tests_encoder[] = {
         .f = test_encode_double_to_float,
         .n = "Double reduction encoder test",
     },
+    {
+        .f = test_encode_typed_array,
+        .n = "Typed array encoder test",
+    },
+    {
+        .f = test_encode_uint_bounds,
+        .n = "Integer encoder bounds test",
+    },
+    {
+        .f = test_encode_unchecked,
+        .n = "Unchecked encoder test",
+    },
+    {
+        .f = test_encode_size,
+        .n = "Encoded size test",
+    },
+    {
+        .f = test_encode_sorted_map,
+        .n = "Sorted map encoder test",
+    },
+    {
+        .f = test_encode_container_close,
+        .n = "Backpatched container encoder test",
+    },
+    {
+        .f = test_encode_growable,
+        .n = "Growable buffer encoder test",
+    },
+    {
+        .f = test_encode_buffered,
+        .n = "Buffered stream encoder test",
+    },
+    {
+        .f = test_encode_iovec,
+        .n = "Vectored output encoder test",
+    },
     {
         .f = NULL,
         .n = NULL,
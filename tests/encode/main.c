@@ -37,7 +37,7 @@ static void _encode(nanocbor_encoder_t *enc)
 int main(void)
 {
     nanocbor_encoder_t enc;
-    nanocbor_encoder_init(&enc, NULL, 0);
+    nanocbor_encoder_size_init(&enc);
 
     _encode(&enc);
 
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+"""
+Generate a NanoCBOR struct description with a perfect hash table.
+
+The input is a JSON description of a struct:
+
+    {
+        "name": "sensor",
+        "struct": "struct sensor",
+        "include": "sensor.h",
+        "fields": [
+            {"key": "id", "member": "id", "type": "uint32", "required": true},
+            {"key": -1, "member": "temp", "type": "float"}
+        ]
+    }
+
+Text string keys are given as strings, integer keys as numbers. The output
+is a header defining `<name>_desc`, to be passed to nanocbor_get_struct().
+"""
+import argparse
+import json
+import sys
+
+# Must match _hash_fnv1a in src/internal.h
+FNV_OFFSET_BASIS = 2166136261
+FNV_PRIME = 16777619
+SLOT_EMPTY = 0xff
+FIELDS_MAX = 64
+SEEDS_PER_SIZE = 100000
+
+FIELD_TYPES = [
+    "uint8", "uint16", "uint32", "uint64",
+    "int8", "int16", "int32", "int64",
+    "bool", "float", "double", "bstr", "tstr", "value",
+]
+
+
+def hash_bytes(seed, data):
+    value = FNV_OFFSET_BASIS ^ seed
+    for byte in data:
+        value ^= byte
+        value = (value * FNV_PRIME) & 0xffffffff
+    return value ^ (value >> 16)
+
+
+def hash_key(seed, key):
+    if isinstance(key, str):
+        return hash_bytes(seed, key.encode('utf-8'))
+    return hash_bytes(seed, (key & 0xffffffffffffffff).to_bytes(8, 'big'))
+
+
+def find_perfect_hash(keys):
+    size = 1
+    while size < len(keys):
+        size *= 2
+    while True:
+        for seed in range(SEEDS_PER_SIZE):
+            slots = [SLOT_EMPTY] * size
+            for idx, key in enumerate(keys):
+                slot = hash_key(seed, key) & (size - 1)
+                if slots[slot] != SLOT_EMPTY:
+                    break
+                slots[slot] = idx
+            else:
+                return seed, slots
+        size *= 2
+
+
+def c_string(value):
+    escaped = ""
+    for byte in value.encode('utf-8'):
+        char = chr(byte)
+        if char.isalnum() or char in " _-.:/":
+            escaped += char
+        else:
+            escaped += f"\\{byte:03o}"
+    return f'"{escaped}"'
+
+
+def generate(spec):
+    name = spec["name"]
+    struct = spec["struct"]
+    fields = spec["fields"]
+    if len(fields) > FIELDS_MAX:
+        sys.exit(f"{name}: more than {FIELDS_MAX} fields")
+
+    keys = [field["key"] for field in fields]
+    if len(set((type(key), key) for key in keys)) != len(keys):
+        sys.exit(f"{name}: duplicate keys")
+    for field in fields:
+        if isinstance(field["key"], bool) or \
+                not isinstance(field["key"], (str, int)):
+            sys.exit(f"{name}: key {field['key']} is not a string or integer")
+        if field["type"] not in FIELD_TYPES:
+            sys.exit(f"{name}: unknown type {field['type']}")
+    seed, slots = find_perfect_hash(keys)
+
+    guard = f"NANOCBOR_GEN_{name.upper()}_H"
+    out = [
+        "/*",
+        " * Generated by nanocbor_struct_gen.py, do not edit",
+        " */",
+        "",
+        f"#ifndef {guard}",
+        f"#define {guard}",
+        "",
+        "#include <stddef.h>",
+        "",
+        '#include "nanocbor/nanocbor.h"',
+    ]
+    if "include" in spec:
+        out.append(f'#include "{spec["include"]}"')
+    out += ["", f"static const nanocbor_field_t {name}_fields[] = {{"]
+    for field in fields:
+        key = field["key"]
+        flags = "NANOCBOR_FIELD_FLAG_REQUIRED" if field.get("required") \
+            else "0"
+        out += [
+            "    {",
+            f"        .name = {c_string(key) if isinstance(key, str) else 'NULL'},",
+            f"        .key = {0 if isinstance(key, str) else key},",
+            f"        .offset = offsetof({struct}, {field['member']}),",
+            f"        .type = NANOCBOR_FIELD_{field['type'].upper()},",
+            f"        .flags = {flags},",
+            "    },",
+        ]
+    out += ["};", "", f"static const uint8_t {name}_slots[] = {{"]
+    for start in range(0, len(slots), 8):
+        row = ", ".join(f"0x{slot:02x}" for slot in slots[start:start + 8])
+        out.append(f"    {row},")
+    out += [
+        "};",
+        "",
+        f"static const nanocbor_struct_t {name}_desc = {{",
+        f"    .fields = {name}_fields,",
+        f"    .num_fields = {len(fields)},",
+        f"    .slots = {name}_slots,",
+        f"    .slot_mask = {len(slots) - 1},",
+        f"    .seed = {seed}U,",
+        "};",
+        "",
+        f"#endif /* {guard} */",
+        "",
+    ]
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+            description='Generate a NanoCBOR struct description')
+    parser.add_argument('input', type=str,
+                        help='JSON description of the struct')
+    parser.add_argument('output', type=str,
+                        help='Header file to generate')
+    args = parser.parse_args()
+    with open(args.input, 'r') as f:
+        spec = json.load(f)
+    with open(args.output, 'w') as f:
+        f.write(generate(spec))
+
+
+if __name__ == "__main__":
+    main()